@@ -0,0 +1,134 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <initializer_list>
+
+// Heap allocations made by any thread since the program started
+uint64_t AllocationCount() noexcept;
+
+// Named results of a case that is not a plain timing loop
+typedef std::initializer_list<std::pair<const char*, double>> BenchValues;
+
+/**
+ * Minimal benchmark runner. Each case is repeated until it has run for at
+ * least the minimum time and the average cost per call is printed.
+ *
+ * The results are printed as a table, or as JSON Lines with one object per
+ * case so runs of different commits can be compared by a script.
+ */
+class Bench
+{
+public:
+    explicit Bench(std::string filter, bool json = false)
+        : _filter(std::move(filter)), _json(json) {}
+
+    bool Enabled(const std::string& name) const
+    {
+        return _filter.empty() || name.find(_filter) != std::string::npos;
+    }
+
+    template <typename Fn>
+    void Run(const std::string& name, Fn&& fn)
+    {
+        if (!Enabled(name))
+            return;
+
+        using Clock = std::chrono::steady_clock;
+        uint64_t iterations = 0;
+        const uint64_t allocations = AllocationCount();
+        const auto start = Clock::now();
+        auto elapsed = Clock::duration::zero();
+        do
+        {
+            fn();
+            iterations++;
+            elapsed = Clock::now() - start;
+        } while (elapsed < MIN_TIME);
+
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        if (_json)
+        {
+            const double allocationsPerOp =
+                static_cast<double>(AllocationCount() - allocations) / iterations;
+            PrintJson(name, { { "iterations", static_cast<double>(iterations) },
+                { "ns_per_op", ns / iterations }, { "allocations_per_op", allocationsPerOp } });
+            return;
+        }
+        std::printf("%-48s %12llu iterations %14.1f ns/op\n", name.c_str(),
+            static_cast<unsigned long long>(iterations), ns / iterations);
+    }
+
+    /**
+     * @brief Prints the result of a case measured by hand
+     * @param values Fields of the JSON record
+     * @param format printf format of the text line, after the name
+     */
+    template <typename... Args>
+    void Report(const std::string& name, BenchValues values, const char* format, Args... args)
+    {
+        if (_json)
+        {
+            PrintJson(name, values);
+            return;
+        }
+        std::printf("%-48s ", name.c_str());
+        std::printf(format, args...);
+        std::printf("\n");
+    }
+
+    // Prevents the compiler from discarding a computed result
+    template <typename T>
+    static void Consume(const T& value)
+    {
+        _sink = &value;
+    }
+
+private:
+    static inline const void* volatile _sink = nullptr;
+    static constexpr std::chrono::milliseconds MIN_TIME{ 300 };
+    std::string _filter;
+    bool _json;
+
+    static void PrintJson(const std::string& name, BenchValues values)
+    {
+        // Case names are plain ASCII, only the JSON delimiters are escaped
+        std::string escaped;
+        for (char c : name)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        std::printf("{\"name\":\"%s\"", escaped.c_str());
+        for (const auto& value : values)
+            std::printf(",\"%s\":%.15g", value.first, value.second);
+        std::printf("}\n");
+    }
+};
+
+void RunGitignoreBench(Bench& bench);
+void RunFormatBench(Bench& bench);
+void RunIpcBench(Bench& bench);
+void RunSerializeBench(Bench& bench);
+void RunResponseBench(Bench& bench);
+void RunEditorBench(Bench& bench);
+void RunWorkspaceBench(Bench& bench);
@@ -0,0 +1,85 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> allocations{ 0 };
+}
+
+// Counts the heap allocations of the whole program, see AllocationCount
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+uint64_t AllocationCount() noexcept
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+// Usage: DiscordRPC_bench [--json] [filter]
+// Only the cases whose name contains the filter are run. With --json every
+// result is printed as one JSON object per line.
+int main(int argc, char* argv[])
+{
+    bool json = false;
+    std::string filter;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else
+            filter = argv[i];
+    }
+    Bench bench(filter, json);
+
+    try
+    {
+        RunGitignoreBench(bench);
+        RunWorkspaceBench(bench);
+        RunFormatBench(bench);
+        RunEditorBench(bench);
+        RunSerializeBench(bench);
+        RunResponseBench(bench);
+        RunIpcBench(bench);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "DiscordRPC_bench: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
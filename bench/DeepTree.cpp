@@ -0,0 +1,79 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "DeepTree.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const char* const LEVELS[DeepTree::DEPTH] =
+    {
+        "src", "DiscordRPC", "modules", "editor", "core", "detail", "platform", "win32",
+        "internal", "generated", "v2", "impl", "handlers", "io", "pipes", "tests"
+    };
+
+    const char* const FILES[] =
+    {
+        "main.cpp", "Presence.hpp", "index.js", "module.pyc", "Debug.log", "app.pdb",
+        "settings.json", ".env", "Project.csproj.user", "README.md"
+    };
+
+    void CopyCorpus(const std::string& name, const fs::path& to)
+    {
+        fs::copy_file(fs::path(DISCORDRPC_BENCH_CORPUS) / name, to, fs::copy_options::overwrite_existing);
+    }
+}
+
+DeepTree::DeepTree()
+{
+    fs::path dir = fs::temp_directory_path() / "DiscordRPC_bench_tree";
+    fs::remove_all(dir);
+    fs::create_directories(dir / ".git");
+    CopyCorpus("git_config", dir / ".git" / "config");
+    CopyCorpus("VisualStudio.gitignore", dir / ".gitignore");
+    _directories.push_back(dir.string());
+
+    for (int level = 0; level < DEPTH; level++)
+    {
+        dir /= LEVELS[level];
+        fs::create_directory(dir);
+        _directories.push_back(dir.string());
+
+        // Nested ignore files like the ones of vendored packages
+        if (level % 4 == 3)
+            CopyCorpus(level % 8 == 3 ? "Node.gitignore" : "Python.gitignore", dir / ".gitignore");
+
+        for (const char* file : FILES)
+        {
+            std::ofstream out(dir / file);
+            if (!out)
+                throw std::runtime_error("DeepTree: cannot create " + (dir / file).string());
+        }
+    }
+
+    for (const char* file : FILES)
+        _files.push_back((dir / file).string());
+}
+
+DeepTree::~DeepTree()
+{
+    std::error_code ec;
+    fs::remove_all(Root(), ec);
+}
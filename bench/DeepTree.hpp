@@ -0,0 +1,47 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * Temporary repository with a deep directory tree built from the corpus:
+ * .git/config at the root, the corpus .gitignore files spread over the
+ * levels and the usual mix of sources and build outputs in every
+ * directory. It is removed on destruction.
+ */
+class DeepTree
+{
+public:
+    static constexpr int DEPTH = 16;
+
+    DeepTree();
+    ~DeepTree();
+
+    DeepTree(const DeepTree&) = delete;
+    DeepTree& operator=(const DeepTree&) = delete;
+
+    const std::string& Root() const noexcept { return _directories.front(); }
+    // From the root to the deepest directory
+    const std::vector<std::string>& Directories() const noexcept { return _directories; }
+    // Files of the deepest directory
+    const std::vector<std::string>& Files() const noexcept { return _files; }
+
+private:
+    std::vector<std::string> _directories;
+    std::vector<std::string> _files;
+};
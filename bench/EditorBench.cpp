@@ -0,0 +1,191 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+#include "DeepTree.hpp"
+#include "NppStub.hpp"
+#include "TextEditorInfo.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    const char* const DETAILS = "Editing: %(file)";
+    const char* const STATE = "Line %(line):%(column) of %(line_count), %(size)";
+    const char* const LARGE_TEXT = "Editing a %(LANG) file";
+
+    struct Language
+    {
+        const wchar_t* extension;
+        LangType type;
+    };
+
+    const Language LANGUAGES[] =
+    {
+        { L".cpp", L_CPP }, { L".py", L_PYTHON }, { L".js", L_JAVASCRIPT },
+        { L".cs", L_CS }, { L".rs", L_RUST }, { L".txt", L_TEXT }
+    };
+
+    // One notification of the editor and the state it leaves behind
+    struct TraceEvent
+    {
+        unsigned reasons;
+        int line, column;
+        int64_t length;
+        size_t buffer; // Index in the open files
+    };
+
+    /**
+     * Synthetic session: bursts of typing with the caret moving along, a
+     * new line every few words, jumps to other lines and a tab switch every
+     * few hundred notifications. Seeded, every run replays the same trace.
+     */
+    std::vector<TraceEvent> MakeTypingTrace(size_t events, size_t buffers)
+    {
+        std::mt19937 random(2026);
+        std::vector<TraceEvent> trace;
+        TraceEvent state{ UPDATE_BUFFER, 0, 0, 48000, 0 };
+        for (size_t i = 0; i < events; i++)
+        {
+            const unsigned roll = random() % 1000;
+            if (roll < 3)
+            {
+                state.reasons = UPDATE_BUFFER;
+                state.buffer = (state.buffer + 1 + random() % (buffers - 1)) % buffers;
+                state.line = static_cast<int>(random() % 2000);
+                state.column = 0;
+                state.length = 1000 + random() % 200000;
+            }
+            else if (roll < 30)
+            {
+                state.reasons = UPDATE_CURSOR;
+                state.line = static_cast<int>(random() % 2000);
+                state.column = static_cast<int>(random() % 80);
+            }
+            else if (roll < 80)
+            {
+                state.reasons = UPDATE_CURSOR;
+                state.line++;
+                state.column = 0;
+                state.length++;
+            }
+            else
+            {
+                state.reasons = UPDATE_CURSOR;
+                state.column++;
+                state.length++;
+            }
+            trace.push_back(state);
+        }
+        return trace;
+    }
+
+    void Apply(const TraceEvent& event, const std::vector<std::string>& directories)
+    {
+        if (event.reasons & UPDATE_BUFFER)
+        {
+            const Language& language = LANGUAGES[event.buffer % (sizeof(LANGUAGES) / sizeof(LANGUAGES[0]))];
+            const std::string& directory = directories[directories.size() - 1 - event.buffer % directories.size()];
+            fakeEditor.directory.assign(directory.begin(), directory.end());
+            fakeEditor.fileName = std::wstring(L"file") + std::to_wstring(event.buffer) + language.extension;
+            fakeEditor.extension = language.extension;
+            fakeEditor.language = language.type;
+        }
+        fakeEditor.line = event.line;
+        fakeEditor.column = event.column;
+        fakeEditor.length = event.length;
+        fakeEditor.lineCount = event.line + 40;
+        fakeEditor.position = event.length / 2;
+    }
+}
+
+void RunEditorBench(Bench& bench)
+{
+    for (const Language& language : LANGUAGES)
+    {
+        const std::wstring wide = language.extension;
+        const std::string extension(wide.begin() + 1, wide.end());
+        fakeEditor.language = language.type;
+        bench.Run("editor/language/" + extension, [&] {
+            LanguageInfo info = LanguageInfo::GetLanguageInfo(extension);
+            Bench::Consume(info);
+        });
+    }
+
+    const char* const TRACE_CASES[] = { "editor/trace/capture", "editor/trace/pipeline", "editor/trace/messages" };
+    bool traceEnabled = false;
+    for (const char* name : TRACE_CASES)
+        traceEnabled = traceEnabled || bench.Enabled(name);
+    if (!traceEnabled)
+        return;
+
+    // The open files live at different depths of a repository
+    const DeepTree tree;
+    constexpr size_t BUFFERS = 8;
+    const std::vector<TraceEvent> trace = MakeTypingTrace(100000, BUFFERS);
+
+    const FormatProgram details(DETAILS), state(STATE), largeText(LARGE_TEXT);
+    EditorQuery query;
+    query.tokens = details.GetTokenMask() | state.GetTokenMask() | largeText.GetTokenMask();
+    query.idleDetection = true;
+    query.workspace = true;
+    query.language = true;
+
+    TextEditorInfo editor;
+    EditorSnapshot snapshot;
+    snapshot.details = &details;
+    snapshot.state = &state;
+    snapshot.largeText = &largeText;
+    snapshot.hideIfPrivate = true;
+    snapshot.buttonRepository = true;
+    snapshot.workspace = true;
+
+    // The editor thread part of an update: Notepad++ messages and the copy
+    // into the snapshot
+    size_t next = 0;
+    bench.Run("editor/trace/capture", [&] {
+        const TraceEvent& event = trace[next++ % trace.size()];
+        Apply(event, tree.Directories());
+        editor.LoadEditorStatus(event.reasons, query);
+        editor.CaptureSnapshot(snapshot);
+        Bench::Consume(snapshot);
+    });
+
+    // The whole update but the IPC, as if the resolver ran inline
+    PresenceResolver resolver;
+    next = 0;
+    bench.Run("editor/trace/pipeline", [&] {
+        const TraceEvent& event = trace[next++ % trace.size()];
+        Apply(event, tree.Directories());
+        editor.LoadEditorStatus(event.reasons, query);
+        editor.CaptureSnapshot(snapshot);
+        Bench::Consume(resolver.Resolve(snapshot));
+    });
+
+    if (bench.Enabled("editor/trace/messages"))
+    {
+        constexpr size_t EVENTS = 10000;
+        fakeEditor.messages = 0;
+        for (size_t i = 0; i < EVENTS; i++)
+        {
+            Apply(trace[i], tree.Directories());
+            editor.LoadEditorStatus(trace[i].reasons, query);
+        }
+        const double perUpdate = static_cast<double>(fakeEditor.messages) / EVENTS;
+        bench.Report("editor/trace/messages", { { "messages_per_update", perUpdate } },
+            "%.2f Notepad++ messages per update", perUpdate);
+    }
+}
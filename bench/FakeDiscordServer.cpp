@@ -0,0 +1,315 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _WIN32
+
+#include "FakeDiscordServer.hpp"
+#include "UnixSocketTransport.hpp"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+    constexpr uint32_t OP_HANDSHAKE = 0;
+    constexpr uint32_t OP_FRAME = 1;
+    constexpr uint32_t OP_CLOSE = 2;
+    constexpr uint32_t OP_PING = 3;
+    constexpr uint32_t OP_PONG = 4;
+
+    struct Header
+    {
+        uint32_t opcode;
+        uint32_t length;
+    };
+}
+
+FakeDiscordServer::FakeDiscordServer(int index, FakeDiscordScript script)
+    : _script(script)
+{
+    _path = UnixSocketTransport::RuntimeDirectory() + "/discord-ipc-" + std::to_string(index);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (_path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("socket path too long: " + _path);
+    std::memcpy(address.sun_path, _path.c_str(), _path.size() + 1);
+
+    ::unlink(_path.c_str());
+    _listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listener < 0 ||
+        ::bind(_listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(_listener, 4) != 0 || ::pipe(_stopPipe) != 0)
+    {
+        const std::string error = std::strerror(errno);
+        if (_listener >= 0)
+            ::close(_listener);
+        throw std::runtime_error("cannot listen on " + _path + ": " + error);
+    }
+
+    _thread = std::thread(&FakeDiscordServer::Serve, this);
+}
+
+FakeDiscordServer::~FakeDiscordServer()
+{
+    const char byte = 1;
+    [[maybe_unused]] ssize_t written = ::write(_stopPipe[1], &byte, 1);
+    _thread.join();
+
+    ::close(_listener);
+    ::close(_stopPipe[0]);
+    ::close(_stopPipe[1]);
+    ::unlink(_path.c_str());
+}
+
+FakeDiscordStats FakeDiscordServer::Stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+bool FakeDiscordServer::WaitForDetails(const std::string& details, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _changed.wait_for(lock, timeout, [&] { return _lastDetails == details; });
+}
+
+bool FakeDiscordServer::WaitForConnections(uint64_t count, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _changed.wait_for(lock, timeout, [&] { return _stats.connections >= count; });
+}
+
+void FakeDiscordServer::Serve()
+{
+    while (true)
+    {
+        pollfd fds[2] = { { _stopPipe[0], POLLIN, 0 }, { _listener, POLLIN, 0 } };
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[0].revents)
+            return;
+
+        const int client = ::accept(_listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.connections++;
+        }
+        _changed.notify_all();
+
+        ServeClient(client);
+        ::close(client);
+    }
+}
+
+void FakeDiscordServer::ServeClient(int client)
+{
+    uint32_t activities = 0;
+    std::string body;
+
+    while (true)
+    {
+        Header header{};
+        if (!ReadExact(client, &header, sizeof(header)))
+            return;
+        body.resize(header.length);
+        if (header.length > 0 && !ReadExact(client, body.data(), body.size()))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.bytesReceived += sizeof(header) + header.length;
+        }
+
+        if (_script.responseDelay.count() > 0)
+            std::this_thread::sleep_for(_script.responseDelay);
+
+        switch (header.opcode)
+        {
+        case OP_HANDSHAKE:
+            if (_script.rejectHandshake)
+            {
+                SendFrame(client, OP_CLOSE, R"({"code":4000,"message":"Invalid Client ID"})");
+                return;
+            }
+            if (!SendUnsolicited(client) || !SendFrame(client, OP_FRAME,
+                    R"({"cmd":"DISPATCH","data":{"v":1,"config":{"api_endpoint":"//discord.com/api"},)"
+                    R"("user":{"id":"0","username":"fake"}},"evt":"READY","nonce":null})"))
+                return;
+            break;
+        case OP_PING:
+            if (!SendFrame(client, OP_PONG, body))
+                return;
+            break;
+        case OP_PONG:
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.pongsReceived++;
+            break;
+        }
+        case OP_CLOSE:
+            return;
+        case OP_FRAME:
+        {
+            nlohmann::json request = nlohmann::json::parse(body, nullptr, false);
+            if (request.is_discarded() || request.value("cmd", "") != "SET_ACTIVITY")
+                break;
+
+            activities++;
+            const nlohmann::json& activity = request["args"]["activity"];
+            const bool isError = _script.errorEvery && activities % _script.errorEvery == 0;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.activities++;
+                _stats.errors += isError;
+                if (activity.is_object())
+                    _lastDetails = activity.value("details", "");
+            }
+            _changed.notify_all();
+
+            if (!_script.silent)
+            {
+                nlohmann::json response = {
+                    { "cmd", "SET_ACTIVITY" },
+                    { "nonce", request.value("nonce", "") }
+                };
+                if (isError)
+                {
+                    response["evt"] = "ERROR";
+                    response["data"] = { { "code", 4002 }, { "message", "Injected error" } };
+                }
+                else
+                {
+                    response["evt"] = nullptr;
+                    response["data"] = activity;
+                }
+                if (!SendUnsolicited(client) || !SendFrame(client, OP_FRAME, response.dump()))
+                    return;
+            }
+
+            if (_script.disconnectAfter && activities >= _script.disconnectAfter)
+                return;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+bool FakeDiscordServer::ReadExact(int client, void* data, size_t size)
+{
+    char* out = static_cast<char*>(data);
+    while (size > 0)
+    {
+        pollfd fds[2] = { { _stopPipe[0], POLLIN, 0 }, { client, POLLIN, 0 } };
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (fds[0].revents)
+            return false;
+
+        const ssize_t received = ::recv(client, out, size, 0);
+        if (received <= 0)
+        {
+            if (received < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        out += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool FakeDiscordServer::SendUnsolicited(int client)
+{
+    if (!_script.unsolicited)
+        return true;
+
+    uint64_t ping = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ping = ++_stats.pingsSent;
+    }
+    return SendFrame(client, OP_PING, R"({"nonce":"server-)" + std::to_string(ping) + R"("})") &&
+        SendFrame(client, OP_FRAME, R"({"cmd":"DISPATCH","data":{"secret":"x"},"evt":"ACTIVITY_JOIN","nonce":null})");
+}
+
+bool FakeDiscordServer::SendFrame(int client, uint32_t opcode, const std::string& payload)
+{
+    const Header header{ opcode, static_cast<uint32_t>(payload.size()) };
+    std::string frame(reinterpret_cast<const char*>(&header), sizeof(header));
+    frame += payload;
+
+    const size_t chunk = _script.chunkSize ? _script.chunkSize : frame.size();
+    for (size_t offset = 0; offset < frame.size(); )
+    {
+        if (offset > 0 && _script.chunkDelay.count() > 0)
+            std::this_thread::sleep_for(_script.chunkDelay);
+
+        const size_t size = std::min(chunk, frame.size() - offset);
+        const ssize_t sent = ::send(client, frame.data() + offset, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            if (sent < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.bytesSent += frame.size();
+    return true;
+}
+
+RuntimeDirectory::RuntimeDirectory()
+{
+    char path[] = "/tmp/discordrpc-bench-XXXXXX";
+    if (!::mkdtemp(path))
+        throw std::runtime_error("cannot create the runtime directory");
+    _path = path;
+    ::setenv("XDG_RUNTIME_DIR", path, 1);
+}
+
+RuntimeDirectory::~RuntimeDirectory()
+{
+    std::error_code ec;
+    std::filesystem::remove_all(_path, ec);
+}
+
+#endif // !_WIN32
@@ -0,0 +1,128 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Private XDG_RUNTIME_DIR for the lifetime of the object, the client and
+ * the fake server meet there and never in the socket of a real Discord
+ * client
+ */
+class RuntimeDirectory
+{
+public:
+    RuntimeDirectory();
+    ~RuntimeDirectory();
+
+    RuntimeDirectory(const RuntimeDirectory&) = delete;
+    RuntimeDirectory& operator=(const RuntimeDirectory&) = delete;
+
+private:
+    std::string _path;
+};
+
+/**
+ * Faults injected by FakeDiscordServer. The defaults behave like a healthy
+ * Discord client.
+ */
+struct FakeDiscordScript
+{
+    // Delay before every response
+    std::chrono::milliseconds responseDelay{ 0 };
+    // Responses are written in pieces of this size (0: in one write), with
+    // the delay between them, so the client sees partial reads
+    size_t chunkSize = 0;
+    std::chrono::milliseconds chunkDelay{ 0 };
+    // Every Nth SET_ACTIVITY is answered with an ERROR event (0: never)
+    uint32_t errorEvery = 0;
+    // The connection is closed after this many SET_ACTIVITY (0: never)
+    uint32_t disconnectAfter = 0;
+    // The handshake is answered with OP_CLOSE, as for an unknown client ID
+    bool rejectHandshake = false;
+    // SET_ACTIVITY is never answered
+    bool silent = false;
+    // A PING and an unrelated event come before READY and before every
+    // answer, as Discord may push them at any time
+    bool unsolicited = false;
+};
+
+struct FakeDiscordStats
+{
+    uint64_t connections = 0;
+    uint64_t activities = 0;  // SET_ACTIVITY frames received
+    uint64_t errors = 0;      // ERROR events sent
+    uint64_t pingsSent = 0;
+    uint64_t pongsReceived = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t bytesSent = 0;
+};
+
+/**
+ * Local stand-in for the Discord client: listens on
+ * <RuntimeDirectory>/discord-ipc-<index> and speaks the IPC protocol with
+ * one client at a time, with the faults of its script.
+ */
+class FakeDiscordServer
+{
+public:
+    FakeDiscordServer(int index, FakeDiscordScript script);
+    ~FakeDiscordServer();
+
+    FakeDiscordServer(const FakeDiscordServer&) = delete;
+    FakeDiscordServer& operator=(const FakeDiscordServer&) = delete;
+
+    FakeDiscordStats Stats() const;
+
+    /**
+     * @brief Waits until a SET_ACTIVITY with the details was received
+     * @return false on timeout
+     */
+    bool WaitForDetails(const std::string& details, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Waits until the number of connections reaches the count
+     */
+    bool WaitForConnections(uint64_t count, std::chrono::milliseconds timeout);
+
+private:
+    FakeDiscordScript _script;
+    std::string _path;
+    int _listener = -1;
+    int _stopPipe[2] = { -1, -1 };
+    std::thread _thread;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _changed;
+    FakeDiscordStats _stats;
+    std::string _lastDetails;
+
+    void Serve();
+    void ServeClient(int client);
+    bool ReadExact(int client, void* data, size_t size);
+    bool SendFrame(int client, uint32_t opcode, const std::string& payload);
+    bool SendUnsolicited(int client);
+};
+
+#endif // !_WIN32
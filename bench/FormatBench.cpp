@@ -0,0 +1,121 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+#include "PresenceFormat.h"
+
+#include <stdexcept>
+#include "StringBuilder.h"
+
+namespace
+{
+    // Property values of a typical editing session, in FormatToken order
+    const std::string PROPS[TOKEN_COUNT] =
+    {
+        "PluginDefinition.cpp", "cpp", "1542", "37", "48.2 KB", "2210",
+        "c++", "C++", "C++", "61873", "notepadpp_rpc"
+    };
+
+    const char* const TEMPLATES[][2] =
+    {
+        { "details/default",    "Editing: %(file)" },
+        { "state/default",      "Size: %(size)" },
+        { "large_text/default", "Editing a %(LANG) file" },
+        { "position",           "Line %(line):%(column) of %(line_count) (%(position))" },
+        { "everything",         "%(workspace)/%(file) [%(extension), %(Lang)] %(line):%(column) %(size)" },
+        { "no_tokens",          "Working on something secret, please do not disturb" },
+        { "unknown_tokens",     "%(branch) %(file) %(commit) 100%(" },
+        { "truncated",          "%(file) %(file) %(file) %(file) %(file) %(file) %(file) %(workspace)" },
+        // Close to the 127 characters the options accept
+        { "long",               "%(workspace) | %(file) (%(extension)) | %(Lang) | Ln %(line), Col %(column), "
+                                "Pos %(position) | %(line_count) lines | %(size)" },
+    };
+
+    /**
+     * TextEditorInfo::WriteFormat before the formats were compiled: every
+     * "%(" is compared with all the tokens on each render.
+     */
+    void LegacyWriteFormat(std::string& buffer, const char* format)
+    {
+        auto containsTag = [](const char* format, const char* tag, size_t pos) {
+            for (size_t i = 0; tag[i] != '\0'; i++)
+                if (format[pos] == '\0' || format[pos++] != tag[i])
+                    return false;
+            return true;
+        };
+
+        char buf[128] = { '\0' };
+        StringBuilder builder(buf, sizeof buf);
+        bool _continue;
+        for (size_t i = 0; format[i] != '\0' && !builder.IsFull(); i++)
+        {
+            _continue = false;
+            if (format[i] == '%' && format[i + 1] == '(' && format[i + 2] != '\0')
+            {
+                for (size_t k = 0; k < TOKEN_COUNT; k++)
+                {
+                    const std::string key = FORMAT_TOKENS[k];
+                    if (format[i + 2] == key[2] && containsTag(format, key.c_str(), i))
+                    {
+                        builder.Append(PROPS[k]);
+                        i += key.length() - 1;
+                        _continue = true;
+                        break;
+                    }
+                }
+            }
+            if (_continue) continue;
+            builder.Append(format[i]);
+        }
+
+        buffer = buf;
+    }
+}
+
+void RunFormatBench(Bench& bench)
+{
+    auto source = [](FormatToken token) -> const std::string& { return PROPS[token]; };
+
+    for (const auto& entry : TEMPLATES)
+    {
+        const std::string prefix = std::string("format/") + entry[0];
+        const char* format = entry[1];
+
+        FormatProgram program(format);
+        std::string legacy, compiled;
+        LegacyWriteFormat(legacy, format);
+        program.Render(compiled, source);
+        if (legacy != compiled)
+        {
+            throw std::runtime_error(prefix + ": the compiled format renders \"" + compiled +
+                "\" instead of \"" + legacy + "\"");
+        }
+
+        bench.Run(prefix + "/compile", [&] {
+            FormatProgram p(format);
+            Bench::Consume(p);
+        });
+
+        bench.Run(prefix + "/render/legacy", [&] {
+            LegacyWriteFormat(legacy, format);
+            Bench::Consume(legacy);
+        });
+
+        bench.Run(prefix + "/render/compiled", [&] {
+            program.Render(compiled, source);
+            Bench::Consume(compiled);
+        });
+    }
+}
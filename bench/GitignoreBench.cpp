@@ -0,0 +1,305 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+#include "FileFilter.hpp"
+
+#include <regex>
+#include <vector>
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+namespace
+{
+    /**
+     * The FileFilter implementation before the patterns were precompiled:
+     * every check converts each pattern to a std::regex.
+     */
+    class LegacyRegexFilter
+    {
+    public:
+        void LoadGitignore(const std::string& gitignorePath)
+        {
+            ignorePatterns.clear();
+            std::ifstream file(gitignorePath);
+            std::string line;
+            while (std::getline(file, line))
+            {
+                line.erase(0, line.find_first_not_of(" \t"));
+                line.erase(line.find_last_not_of(" \t") + 1);
+                if (line.empty() || line[0] == '#')
+                    continue;
+                ignorePatterns.push_back(line);
+            }
+            currentParent = std::filesystem::path(gitignorePath).parent_path().string();
+        }
+
+        bool IsPrivate(const std::string& filePath) const
+        {
+            std::string normalizedPath = filePath;
+            std::replace(normalizedPath.begin(), normalizedPath.end(), '\\', '/');
+
+            for (const auto& pattern : ignorePatterns)
+                if (MatchesPattern(pattern, normalizedPath))
+                    return true;
+            return false;
+        }
+
+    private:
+        std::vector<std::string> ignorePatterns;
+        std::string currentParent;
+
+        static std::regex ConvertPatternToRegex(const std::string& pattern)
+        {
+            std::string rx = pattern;
+            std::replace(rx.begin(), rx.end(), '\\', '/');
+
+            if (!rx.empty() && rx[0] == '/')
+                rx.erase(0, 1);
+
+            rx = std::regex_replace(rx, std::regex(R"(\*\*)"), R"(.*)");
+            rx = std::regex_replace(rx, std::regex(R"(\*)"), R"([^/]*)");
+            rx = std::regex_replace(rx, std::regex(R"(\?)"), R"([^/])");
+            return std::regex(rx);
+        }
+
+        bool MatchesPattern(const std::string& pattern, const std::string& filePath) const
+        {
+            std::error_code ec;
+            std::filesystem::path relative = std::filesystem::relative(filePath, currentParent, ec);
+            if (ec) relative = std::filesystem::path(filePath).filename();
+
+            std::string normalized = relative.string();
+            std::replace(normalized.begin(), normalized.end(), '\\', '/');
+
+            try
+            {
+                return std::regex_search(normalized, ConvertPatternToRegex(pattern));
+            }
+            catch (const std::regex_error&)
+            {
+                return false; // "[Dd]ebug" style patterns may not be valid regexes
+            }
+        }
+    };
+
+    /**
+     * Result of `git check-ignore` for paths relative to the .gitignore of
+     * each corpus. Covers negation, directory-only, anchored, "**" and
+     * character class patterns.
+     */
+    struct ExpectedResult
+    {
+        const char* corpus;
+        const char* path;
+        bool ignored;
+    };
+
+    const ExpectedResult EXPECTED_RESULTS[] = {
+        { "Node", "index.js",                                   false },
+        { "Node", "src/app.js",                                 false },
+        { "Node", "node_modules/lodash/index.js",               true },
+        { "Node", "src/node_modules/x/index.js",                true },
+        { "Node", "report.20240101.123456.789.001.json",        true },
+        { "Node", "report.json",                                false },
+        { "Node", "logs/app.log",                               true },
+        { "Node", "npm-debug.log",                              true },
+        { "Node", "npm-debug.log.1",                            true },
+        { "Node", ".env",                                       true },
+        { "Node", ".env.example",                               false },
+        { "Node", "dist/bundle.js",                             true },
+        { "Node", "src/dist/bundle.js",                         true },
+        { "Node", ".cache/data",                                true },
+        { "Node", "coverage/lcov.info",                         true },
+        { "Node", "lib-cov/x.js",                               true },
+        { "Node", "build/Release/addon.node",                   true },
+        { "Node", "build/Debug/addon.node",                     false },
+        { "Node", ".yarn/cache/a.zip",                          true },
+        { "Node", ".yarn/releases/yarn.js",                     false },
+        { "Node", "README.md",                                  false },
+        { "Node", "web_modules/x.js",                           true },
+        { "Node", "src/.cache",                                 true },
+        { "Node", "out/index.js",                               true },
+        { "Node", ".vscode-test/x",                             true },
+        { "Python", "main.py",                                  false },
+        { "Python", "module.pyc",                               true },
+        { "Python", "module.pyo",                               true },
+        { "Python", "module.pyd",                               true },
+        { "Python", "module.pyx",                               false },
+        { "Python", "pkg/__pycache__/m.cpython-312.pyc",        true },
+        { "Python", "__pycache__",                              false },
+        { "Python", "site/index.html",                          true },
+        { "Python", "site",                                     true },
+        { "Python", "docs/site/index.html",                     false },
+        { "Python", "docs/_build/html/index.html",              true },
+        { "Python", "_build/x",                                 false },
+        { "Python", "build/lib/pkg.py",                         true },
+        { "Python", "src/build/x.py",                           true },
+        { "Python", "lib/python3/x.py",                         true },
+        { "Python", "src/lib/x.py",                             true },
+        { "Python", "pkg.egg-info/PKG-INFO",                    true },
+        { "Python", ".venv/bin/python",                         true },
+        { "Python", "venv/bin/python",                          true },
+        { "Python", "env/bin/python",                           true },
+        { "Python", "src/env.py",                               false },
+        { "Python", ".env",                                     true },
+        { "Python", "dist/pkg.whl",                             true },
+        { "Python", "instance/config.py",                       true },
+        { "Python", "app.spec",                                 true },
+        { "Python", "htmlcov/index.html",                       true },
+        { "Python", ".pytest_cache/v",                          true },
+        { "Python", "target/x",                                 true },
+        { "Python", "setup.py",                                 false },
+        { "Python", "requirements.txt",                         false },
+        { "VisualStudio", "src/main.cpp",                       false },
+        { "VisualStudio", "bin/Debug/app.exe",                  true },
+        { "VisualStudio", "Debug/app.exe",                      true },
+        { "VisualStudio", "debug/app.exe",                      true },
+        { "VisualStudio", "DEBUG/app.exe",                      false },
+        { "VisualStudio", "src/Release/app.dll",                true },
+        { "VisualStudio", "Win32/Debug/x.obj",                  true },
+        { "VisualStudio", "wIN32/x",                            true },
+        { "VisualStudio", "ARM64/x",                            true },
+        { "VisualStudio", "obj/Release/net8.0/app.dll",         true },
+        { "VisualStudio", "Obj/x",                              true },
+        { "VisualStudio", ".vs/DiscordRPC/v17/.suo",            true },
+        { "VisualStudio", "app.pdb",                            true },
+        { "VisualStudio", "Project.csproj.user",                true },
+        { "VisualStudio", "TestResult1/x.trx",                  true },
+        { "VisualStudio", "TestResults/x.trx",                  true },
+        { "VisualStudio", "BuildLog.htm",                       true },
+        { "VisualStudio", "buildlog.txt",                       true },
+        { "VisualStudio", "packages/Newtonsoft.Json/lib/a.dll", true },
+        { "VisualStudio", "src/packages/x/a.dll",               true },
+        { "VisualStudio", "packages/build/x.targets",           false },
+        { "VisualStudio", "Packages/build/x.targets",           false },
+        { "VisualStudio", "packages/repositories.config",       true },
+        { "VisualStudio", ".axoCover/settings.json",            false },
+        { "VisualStudio", ".axoCover/data.db",                  true },
+        { "VisualStudio", ".vscode/settings.json",              false },
+        { "VisualStudio", ".vscode/other.json",                 true },
+        { "VisualStudio", "a.cache",                            true },
+        { "VisualStudio", "dir.cache/file.txt",                 false },
+        { "VisualStudio", "x.Cache",                            true },
+        { "VisualStudio", "Generated Files/x.cs",               true },
+        { "VisualStudio", "_ReSharper.Caches/x",                true },
+        { "VisualStudio", "Project.ReSharper",                  true },
+        { "VisualStudio", "app.Publish.xml",                    true },
+        { "VisualStudio", "app.exe",                            false },
+        { "VisualStudio", "README.md",                          false },
+        { "VisualStudio", "log/x.txt",                          true },
+        { "VisualStudio", "Logs/x.txt",                         true },
+        { "VisualStudio", "x64/x",                              true },
+        { "VisualStudio", "bld/x",                              true },
+    };
+
+    std::vector<std::string> MakePaths(const std::string& root)
+    {
+        static const char* const dirs[] = {
+            "", "src/", "src/core/", "src/ui/widgets/", "bin/Debug/", "obj/Release/net8.0/",
+            "node_modules/lodash/", "packages/Newtonsoft.Json/lib/", ".vs/DiscordRPC/v17/",
+            "docs/_build/html/", "tests/unit/"
+        };
+        static const char* const files[] = {
+            "main.cpp", "App.xaml.cs", "index.js", "module.pyc", "Debug.log", "README.md",
+            "settings.json", ".env", "app.exe", "app.pdb", "Project.csproj.user"
+        };
+
+        std::vector<std::string> paths;
+        for (const char* dir : dirs)
+            for (const char* file : files)
+                paths.push_back(root + "/" + dir + file);
+        return paths;
+    }
+}
+
+void RunGitignoreBench(Bench& bench)
+{
+    const std::string corpusDir = DISCORDRPC_BENCH_CORPUS;
+    const std::vector<std::string> paths = MakePaths(corpusDir);
+
+    for (const char* corpus : { "Node", "Python", "VisualStudio" })
+    {
+        const std::string gitignore = corpusDir + "/" + corpus + ".gitignore";
+        const std::string prefix = std::string("gitignore/") + corpus;
+
+        LegacyRegexFilter legacy;
+        legacy.LoadGitignore(gitignore);
+        FileFilter filter;
+        filter.LoadGitignore(gitignore);
+
+        // The compiled matcher must agree with git
+        if (bench.Enabled(prefix + "/check_ignore"))
+        {
+            size_t checked = 0;
+            for (const ExpectedResult& expected : EXPECTED_RESULTS)
+            {
+                if (std::string(expected.corpus) != corpus)
+                    continue;
+                if (filter.IsPrivate(corpusDir + "/" + expected.path) != expected.ignored)
+                {
+                    throw std::runtime_error(prefix + ": " + expected.path + " should " +
+                        (expected.ignored ? "" : "not ") + "be ignored");
+                }
+                checked++;
+            }
+            bench.Report(prefix + "/check_ignore", { { "checked", static_cast<double>(checked) } },
+                "%zu paths equal to git check-ignore", checked);
+        }
+
+        // Only printed with the cases of the corpus, a filter for another
+        // suite runs nothing here
+        if (bench.Enabled(prefix + "/private_count"))
+        {
+            size_t legacyPrivate = 0, compiledPrivate = 0;
+            for (const std::string& path : paths)
+            {
+                legacyPrivate += legacy.IsPrivate(path);
+                compiledPrivate += filter.IsPrivate(path);
+            }
+            bench.Report(prefix + "/private_count", { { "paths", static_cast<double>(paths.size()) },
+                { "regex", static_cast<double>(legacyPrivate) }, { "compiled", static_cast<double>(compiledPrivate) } },
+                "%zu paths, private by regex %zu, by compiled matcher %zu",
+                paths.size(), legacyPrivate, compiledPrivate);
+        }
+
+        bench.Run(prefix + "/load/compiled", [&] {
+            FileFilter f;
+            f.LoadGitignore(gitignore);
+            Bench::Consume(f);
+        });
+
+        // Switching back to a tab of the same workspace, only the
+        // fingerprint is checked
+        bench.Run(prefix + "/load/fingerprint", [&] {
+            filter.LoadGitignore(gitignore);
+            Bench::Consume(filter);
+        });
+
+        size_t index = 0;
+        bench.Run(prefix + "/is_private/regex", [&] {
+            bool result = legacy.IsPrivate(paths[index++ % paths.size()]);
+            Bench::Consume(result);
+        });
+
+        index = 0;
+        bench.Run(prefix + "/is_private/compiled", [&] {
+            bool result = filter.IsPrivate(paths[index++ % paths.size()]);
+            Bench::Consume(result);
+        });
+    }
+}
@@ -0,0 +1,452 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+
+#ifdef _WIN32
+
+void RunIpcBench(Bench&)
+{
+    // The fake Discord server listens on a Unix domain socket
+}
+
+#else
+
+#include "DiscordRichPresence.hpp"
+#include "FakeDiscordServer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr std::chrono::seconds WAIT_LIMIT{ 5 };
+    constexpr int64_t CLIENT_ID = 1234567890;
+
+    struct Client
+    {
+        DiscordRichPresence rpc;
+        std::atomic<uint64_t> reports{ 0 };
+
+        explicit Client(bool arbitrate = false)
+        {
+            rpc.SetArbitration(arbitrate);
+            if (!rpc.Start(CLIENT_ID, [this](const std::string&) { reports++; }))
+                throw std::runtime_error("cannot start the IPC worker");
+        }
+
+        void Post(const std::string& details)
+        {
+            Presence presence;
+            presence.details = details;
+            presence.state = "Workspace: bench";
+            presence.largeImage = "cpp";
+            rpc.PostPresence(presence, false);
+        }
+    };
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Every iteration publishes a new presence and waits until the server
+    // received it
+    void RoundTrip(Bench& bench, const std::string& name, FakeDiscordScript script)
+    {
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordServer server(0, script);
+        Client client;
+        uint64_t sequence = 0;
+        bench.Run(name, [&] {
+            const std::string details = "Editing file " + std::to_string(++sequence);
+            client.Post(details);
+            if (!server.WaitForDetails(details, WAIT_LIMIT))
+                throw std::runtime_error(name + ": the presence did not arrive");
+        });
+    }
+
+    // Presences published faster than Discord answers: only the latest one
+    // has to arrive, the superseded ones are dropped before the pipe
+    void Burst(Bench& bench)
+    {
+        const std::string name = "ipc/burst/latency_20ms";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordScript script;
+        script.responseDelay = std::chrono::milliseconds(20);
+        FakeDiscordServer server(0, script);
+        Client client;
+
+        constexpr int POSTS = 10000;
+        const auto start = Clock::now();
+        for (int i = 1; i <= POSTS; i++)
+            client.Post("Editing file " + std::to_string(i));
+        const double postMs = ElapsedMs(start);
+        if (!server.WaitForDetails("Editing file " + std::to_string(POSTS), WAIT_LIMIT))
+            throw std::runtime_error(name + ": the last presence did not arrive");
+
+        const FakeDiscordStats stats = server.Stats();
+        const double latestMs = ElapsedMs(start);
+        bench.Report(name, { { "posted", POSTS }, { "post_ms", postMs },
+            { "sent", static_cast<double>(stats.activities) }, { "latest_ms", latestMs } },
+            "%d posted in %.1f ms, %llu sent, latest after %.1f ms",
+            POSTS, postMs, static_cast<unsigned long long>(stats.activities), latestMs);
+    }
+
+    // Discord drops a connection that was up for a while, the worker
+    // connects again at once and sends the presence again
+    void Reconnect(Bench& bench)
+    {
+        const std::string name = "ipc/reconnect/stable";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordScript script;
+        script.disconnectAfter = 2;
+        FakeDiscordServer server(0, script);
+        Client client;
+
+        client.Post("Editing file 1");
+        if (!server.WaitForDetails("Editing file 1", WAIT_LIMIT))
+            throw std::runtime_error(name + ": the presence did not arrive");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5100));
+
+        const auto start = Clock::now();
+        client.Post("Editing file 2");
+        if (!server.WaitForConnections(2, WAIT_LIMIT))
+            throw std::runtime_error(name + ": the client did not reconnect");
+        const double reconnectMs = ElapsedMs(start);
+        if (!server.WaitForDetails("Editing file 2", WAIT_LIMIT))
+            throw std::runtime_error(name + ": the presence was not sent again");
+
+        const double sentMs = ElapsedMs(start);
+        bench.Report(name, { { "reconnect_ms", reconnectMs }, { "sent_ms", sentMs } },
+            "reconnected %.2f ms after the presence, sent again after %.2f ms", reconnectMs, sentMs);
+    }
+
+    // The server drops every connection after one presence: the attempts
+    // must back off instead of spinning
+    void Flapping(Bench& bench)
+    {
+        const std::string name = "ipc/reconnect/flapping";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordScript script;
+        script.disconnectAfter = 1;
+        FakeDiscordServer server(0, script);
+        Client client;
+        client.Post("Editing file 1");
+        std::this_thread::sleep_for(std::chrono::seconds(4));
+
+        const FakeDiscordStats stats = server.Stats();
+        bench.Report(name, { { "connections", static_cast<double>(stats.connections) } },
+            "%llu connections in 4 s", static_cast<unsigned long long>(stats.connections));
+    }
+
+    // Discord listens on a later endpoint, the absent ones are skipped by
+    // the probe instead of being waited for
+    void Connect(Bench& bench)
+    {
+        const std::string name = "ipc/connect/endpoint_3";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordServer server(3, FakeDiscordScript{});
+        uint64_t connections = 0;
+        bench.Run(name, [&] {
+            Client client;
+            if (!server.WaitForConnections(++connections, WAIT_LIMIT))
+                throw std::runtime_error(name + ": the client did not connect");
+        });
+    }
+
+    // Discord starts after the plugin: the probes back off while it is
+    // absent, the delay until the connection is bounded by the interval
+    // reached at that point
+    void LateStart(Bench& bench)
+    {
+        const std::string name = "ipc/connect/late_start";
+        if (!bench.Enabled(name))
+            return;
+
+        for (int absentMs : { 100, 1000, 3000 })
+        {
+            Client client;
+            std::this_thread::sleep_for(std::chrono::milliseconds(absentMs));
+            const auto start = Clock::now();
+            FakeDiscordServer server(0, FakeDiscordScript{});
+            if (!server.WaitForConnections(1, std::chrono::seconds(10)))
+                throw std::runtime_error(name + ": the client did not connect");
+            const double connectedMs = ElapsedMs(start);
+            bench.Report(name, { { "absent_ms", absentMs }, { "connected_ms", connectedMs } },
+                "absent %d ms, connected %.1f ms after start", absentMs, connectedMs);
+        }
+    }
+
+    // The idle status is an exact deadline of the worker: it must be sent
+    // when the timeout expires, not on the next poll
+    void Idle(Bench& bench)
+    {
+        const std::string name = "ipc/idle/deadline";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordServer server(0, FakeDiscordScript{});
+        Client client;
+        Presence idle;
+        idle.details = "Idling";
+        client.rpc.SetIdleStatus(&idle, std::chrono::seconds(1));
+
+        for (int i = 1; i <= 3; i++)
+        {
+            const std::string details = "Editing file " + std::to_string(i);
+            const auto start = Clock::now();
+            client.Post(details);
+            if (!server.WaitForDetails(details, WAIT_LIMIT) || !server.WaitForDetails("Idling", WAIT_LIMIT))
+                throw std::runtime_error(name + ": the idle status did not arrive");
+            const double idleMs = ElapsedMs(start);
+            bench.Report(name, { { "timeout_ms", 1000 }, { "idle_ms", idleMs } },
+                "idle status %.1f ms after the activity (timeout 1000 ms)", idleMs);
+        }
+    }
+
+    // An unchanged presence is not sent again, the quiet connection is only
+    // checked with a PING
+    void Heartbeat(Bench& bench)
+    {
+        const std::string name = "ipc/heartbeat";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordServer server(0, FakeDiscordScript{});
+        Client client;
+        client.rpc.SetHeartbeatInterval(std::chrono::seconds(1));
+
+        // The editor reposts the same presence on every refresh
+        const auto start = Clock::now();
+        while (Clock::now() - start < std::chrono::milliseconds(3500))
+        {
+            client.Post("Editing file 1");
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        client.rpc.Close();
+
+        const DiscordIPCStats stats = client.rpc.GetStats();
+        bench.Report(name, { { "activities_sent", static_cast<double>(stats.activitiesSent) },
+            { "activities_skipped", static_cast<double>(stats.activitiesSkipped) },
+            { "pings", static_cast<double>(stats.pingsSent) }, { "pongs", static_cast<double>(stats.pongsReceived) },
+            { "bytes_sent", static_cast<double>(stats.bytesSent) },
+            { "bytes_received", static_cast<double>(stats.bytesReceived) } },
+            "3.5 s: %llu activities sent, %llu skipped, %llu pings, %llu pongs, %llu bytes sent, %llu received",
+            static_cast<unsigned long long>(stats.activitiesSent),
+            static_cast<unsigned long long>(stats.activitiesSkipped),
+            static_cast<unsigned long long>(stats.pingsSent),
+            static_cast<unsigned long long>(stats.pongsReceived),
+            static_cast<unsigned long long>(stats.bytesSent),
+            static_cast<unsigned long long>(stats.bytesReceived));
+    }
+
+    // Every other SET_ACTIVITY is answered with an ERROR event, each one
+    // must reach the error callback
+    void Errors(Bench& bench)
+    {
+        const std::string name = "ipc/errors";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordScript script;
+        script.errorEvery = 2;
+        FakeDiscordServer server(0, script);
+        Client client;
+
+        constexpr int POSTS = 40;
+        for (int i = 1; i <= POSTS; i++)
+        {
+            const std::string details = "Editing file " + std::to_string(i);
+            client.Post(details);
+            if (!server.WaitForDetails(details, WAIT_LIMIT))
+                throw std::runtime_error(name + ": the presence did not arrive");
+        }
+        client.rpc.Close();
+
+        const FakeDiscordStats stats = server.Stats();
+        const uint64_t reports = client.reports.load();
+        bench.Report(name, { { "errors", static_cast<double>(stats.errors) },
+            { "reported", static_cast<double>(reports) }, { "connections", static_cast<double>(stats.connections) } },
+            "%llu errors injected, %llu reported, %llu connections",
+            static_cast<unsigned long long>(stats.errors), static_cast<unsigned long long>(reports),
+            static_cast<unsigned long long>(stats.connections));
+    }
+
+    // Discord pushes PINGs and events between the answers: the PINGs are
+    // answered, the events ignored and no answer is mismatched
+    void Unsolicited(Bench& bench)
+    {
+        const std::string name = "ipc/unsolicited";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordScript script;
+        script.unsolicited = true;
+        FakeDiscordServer server(0, script);
+        Client client;
+
+        constexpr int POSTS = 40;
+        const auto start = Clock::now();
+        for (int i = 1; i <= POSTS; i++)
+        {
+            const std::string details = "Editing file " + std::to_string(i);
+            client.Post(details);
+            if (!server.WaitForDetails(details, WAIT_LIMIT))
+                throw std::runtime_error(name + ": the presence did not arrive");
+        }
+        const double elapsed = ElapsedMs(start);
+        client.rpc.Close();
+
+        const FakeDiscordStats stats = server.Stats();
+        const uint64_t reports = client.reports.load();
+        bench.Report(name, { { "presences", POSTS }, { "elapsed_ms", elapsed },
+            { "pings", static_cast<double>(stats.pingsSent) }, { "pongs", static_cast<double>(stats.pongsReceived) },
+            { "reports", static_cast<double>(reports) }, { "connections", static_cast<double>(stats.connections) } },
+            "%d presences in %.1f ms, %llu pings, %llu pongs, %llu reports, %llu connections",
+            POSTS, elapsed, static_cast<unsigned long long>(stats.pingsSent),
+            static_cast<unsigned long long>(stats.pongsReceived), static_cast<unsigned long long>(reports),
+            static_cast<unsigned long long>(stats.connections));
+    }
+
+    // Notepad++ closes while the handshake waits for Discord: Close runs on
+    // the UI thread and must not wait for the read timeout of the worker
+    void CloseDuringHandshake(Bench& bench)
+    {
+        const std::string name = "ipc/close/during_handshake";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordScript script;
+        script.responseDelay = std::chrono::milliseconds(2000);
+        FakeDiscordServer server(0, script);
+        Client client;
+        if (!server.WaitForConnections(1, WAIT_LIMIT))
+            throw std::runtime_error(name + ": the client did not connect");
+
+        const auto start = Clock::now();
+        client.rpc.Close();
+        const double closeMs = ElapsedMs(start);
+        if (closeMs > 1000)
+            throw std::runtime_error(name + ": Close waited for the handshake");
+        bench.Report(name, { { "close_ms", closeMs } }, "Close returned after %.1f ms", closeMs);
+    }
+
+    // Two editor processes and the user going back and forth between them.
+    // Only the active one keeps the connection and the refreshes of the
+    // editor in the background never reach Discord. The fake server serves
+    // one connection at a time, the time is until the editor left behind
+    // releases it at its next refresh; Discord itself shows the presence of
+    // the new owner as soon as it is sent
+    void Arbitration(Bench& bench)
+    {
+        const std::string name = "ipc/arbitration";
+        if (!bench.Enabled(name))
+            return;
+
+        FakeDiscordServer server(0, FakeDiscordScript{});
+        Client first(true), second(true);
+        Client* editors[] = { &first, &second };
+
+        constexpr int SWITCHES = 6;
+        constexpr int TYPING = 5;
+        double totalMs = 0, maxMs = 0;
+        for (int i = 0; i < SWITCHES; i++)
+        {
+            Client& active = *editors[i % 2];
+            Client& background = *editors[(i + 1) % 2];
+
+            // The workers settle, the editor left behind only notices the
+            // switch at its next refresh
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            const auto start = Clock::now();
+            std::string details;
+            for (int j = 1; j <= TYPING; j++)
+            {
+                details = "Switch " + std::to_string(i) + ", edit " + std::to_string(j);
+                active.Post(details);
+            }
+            if (!server.WaitForDetails(details, WAIT_LIMIT))
+                throw std::runtime_error(name + ": the active editor did not take the presence");
+            const double elapsed = ElapsedMs(start);
+            totalMs += elapsed;
+            maxMs = std::max(maxMs, elapsed);
+
+            Presence refresh;
+            refresh.details = "Background " + std::to_string(i);
+            background.rpc.PostPresence(refresh, true);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (first.rpc.IsConnected() && second.rpc.IsConnected())
+            throw std::runtime_error(name + ": both editors hold a connection");
+
+        const FakeDiscordStats stats = server.Stats();
+        const uint64_t handovers = first.rpc.GetStats().handovers + second.rpc.GetStats().handovers;
+        const double averageMs = totalMs / SWITCHES;
+        bench.Report(name, { { "switches", SWITCHES }, { "handover_ms", averageMs }, { "max_handover_ms", maxMs },
+            { "activities", static_cast<double>(stats.activities) }, { "connections", static_cast<double>(stats.connections) },
+            { "handovers", static_cast<double>(handovers) } },
+            "%d switches, %.1f ms per handover (max %.1f), %llu activities, %llu connections",
+            SWITCHES, averageMs, maxMs, static_cast<unsigned long long>(stats.activities),
+            static_cast<unsigned long long>(stats.connections));
+    }
+}
+
+void RunIpcBench(Bench& bench)
+{
+    bool enabled = false;
+    for (const char* name : { "ipc/round_trip", "ipc/round_trip/partial_reads", "ipc/burst/latency_20ms",
+                              "ipc/reconnect/stable", "ipc/reconnect/flapping", "ipc/errors", "ipc/connect/endpoint_3",
+                              "ipc/connect/late_start", "ipc/idle/deadline", "ipc/heartbeat", "ipc/unsolicited",
+                              "ipc/close/during_handshake", "ipc/arbitration" })
+        enabled = enabled || bench.Enabled(name);
+    if (!enabled)
+        return;
+
+    RuntimeDirectory directory;
+
+    RoundTrip(bench, "ipc/round_trip", FakeDiscordScript{});
+
+    FakeDiscordScript partial;
+    partial.chunkSize = 7;
+    RoundTrip(bench, "ipc/round_trip/partial_reads", partial);
+
+    Burst(bench);
+    Reconnect(bench);
+    Flapping(bench);
+    Errors(bench);
+    Connect(bench);
+    LateStart(bench);
+    Idle(bench);
+    Heartbeat(bench);
+    Unsolicited(bench);
+    CloseDuringHandshake(bench);
+    Arbitration(bench);
+}
+
+#endif // _WIN32
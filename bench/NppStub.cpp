@@ -0,0 +1,179 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "NppStub.hpp"
+#include "PluginUtil.h"
+
+#include <cstring>
+#include <shlwapi.h>
+
+FakeEditor fakeEditor;
+NppData nppData{ &fakeEditor, &fakeEditor, nullptr };
+
+namespace
+{
+    // Text messages fail when the buffer is too small, the caller retries
+    // with a larger one
+    LRESULT CopyText(const std::wstring& text, WPARAM size, LPARAM buffer)
+    {
+        if (text.size() + 1 > size)
+            return FALSE;
+        std::wmemcpy(reinterpret_cast<wchar_t*>(buffer), text.c_str(), text.size() + 1);
+        return TRUE;
+    }
+
+    std::wstring DecodeUtf8(const std::string& text)
+    {
+        // Invalid sequences are skipped, a trace is written by
+        // WideCharToMultiByte and never has them
+        std::wstring out;
+        for (size_t i = 0; i < text.size();)
+        {
+            const unsigned char lead = static_cast<unsigned char>(text[i]);
+            const size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+            if (i + length > text.size())
+                break;
+
+            uint32_t c = length == 1 ? lead : lead & (0x3F >> (length - 1));
+            for (size_t j = 1; j < length; j++)
+                c = (c << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+            i += length;
+
+            if (sizeof(wchar_t) == 2 && c >= 0x10000)
+            {
+                c -= 0x10000;
+                out += static_cast<wchar_t>(0xD800 | (c >> 10));
+                out += static_cast<wchar_t>(0xDC00 | (c & 0x3FF));
+            }
+            else
+                out += static_cast<wchar_t>(c);
+        }
+        return out;
+    }
+}
+
+bool FakeEditor::Answer(unsigned message, int64_t value)
+{
+    switch (message)
+    {
+    case NPPM_GETCURRENTLINE:       line = static_cast<int>(value); return true;
+    case NPPM_GETCURRENTCOLUMN:     column = static_cast<int>(value); return true;
+    case NPPM_GETCURRENTLANGTYPE:   language = static_cast<LangType>(value); return true;
+    case SCI_GETLENGTH:             length = value; return true;
+    case SCI_GETLINECOUNT:          lineCount = static_cast<int>(value); return true;
+    case SCI_GETCURRENTPOS:         position = value; return true;
+    case NPPM_GETCURRENTSCINTILLA:  return true; // A single view
+    default:                        return false;
+    }
+}
+
+bool FakeEditor::Text(unsigned message, const std::string& utf8)
+{
+    switch (message)
+    {
+    case NPPM_GETFILENAME:          fileName = DecodeUtf8(utf8); return true;
+    case NPPM_GETEXTPART:           extension = DecodeUtf8(utf8); return true;
+    case NPPM_GETCURRENTDIRECTORY:  directory = DecodeUtf8(utf8); return true;
+    default:                        return false;
+    }
+}
+
+HWND GetCurrentScintilla()
+{
+    return nppData._scintillaMainHandle;
+}
+
+LRESULT NppSendMessage(HWND, UINT Msg, WPARAM wParam, LPARAM lParam)
+{
+    fakeEditor.messages++;
+    switch (Msg)
+    {
+    case NPPM_GETFILENAME:          return CopyText(fakeEditor.fileName, wParam, lParam);
+    case NPPM_GETEXTPART:           return CopyText(fakeEditor.extension, wParam, lParam);
+    case NPPM_GETCURRENTDIRECTORY:  return CopyText(fakeEditor.directory, wParam, lParam);
+    case NPPM_GETCURRENTLINE:       return fakeEditor.line;
+    case NPPM_GETCURRENTCOLUMN:     return fakeEditor.column;
+    case NPPM_GETCURRENTLANGTYPE:
+        *reinterpret_cast<LangType*>(lParam) = fakeEditor.language;
+        return TRUE;
+    case SCI_GETLENGTH:             return static_cast<LRESULT>(fakeEditor.length);
+    case SCI_GETLINECOUNT:          return fakeEditor.lineCount;
+    case SCI_GETCURRENTPOS:         return static_cast<LRESULT>(fakeEditor.position);
+    default:                        return 0;
+    }
+}
+
+#ifndef _WIN32
+int WideCharToMultiByte(UINT, DWORD, LPCWSTR wide, int wideLength,
+    LPSTR multiByte, int multiByteLength, LPCSTR, BOOL*)
+{
+    // UTF-32 to UTF-8, only the null terminated form the plugin uses
+    std::string out;
+    const size_t length = wideLength < 0 ? std::wcslen(wide) + 1 : static_cast<size_t>(wideLength);
+    for (size_t i = 0; i < length; i++)
+    {
+        const uint32_t c = static_cast<uint32_t>(wide[i]);
+        if (c < 0x80)
+            out += static_cast<char>(c);
+        else if (c < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    if (!multiByte || multiByteLength == 0)
+        return static_cast<int>(out.size());
+    if (out.size() > static_cast<size_t>(multiByteLength))
+        return 0;
+    std::memcpy(multiByte, out.data(), out.size());
+    return static_cast<int>(out.size());
+}
+
+LPSTR StrFormatByteSize64A(LONGLONG size, LPSTR buffer, UINT bufferSize)
+{
+    // Same shape as the Windows answer: three significant digits
+    static const char* const units[] = { "KB", "MB", "GB", "TB" };
+    if (size < 1024)
+    {
+        std::snprintf(buffer, bufferSize, "%lld bytes", static_cast<long long>(size));
+        return buffer;
+    }
+
+    double value = static_cast<double>(size) / 1024;
+    size_t unit = 0;
+    while (value >= 1024 && unit + 1 < sizeof(units) / sizeof(units[0]))
+    {
+        value /= 1024;
+        unit++;
+    }
+    std::snprintf(buffer, bufferSize, value < 10 ? "%.2f %s" : value < 100 ? "%.1f %s" : "%.0f %s",
+        value, units[unit]);
+    return buffer;
+}
+#endif // _WIN32
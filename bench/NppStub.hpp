@@ -0,0 +1,51 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "PluginInterface.h"
+
+/**
+ * Editor state that the stubbed NppSendMessage answers with. A benchmark
+ * edits it between updates the way a user session would.
+ */
+struct FakeEditor
+{
+    std::wstring fileName = L"PluginDefinition.cpp";
+    std::wstring extension = L".cpp";
+    std::wstring directory = L"/tmp";
+    LangType language = L_CPP;
+    int line = 0;   // Zero based, as Notepad++ answers
+    int column = 0;
+    int64_t length = 0;
+    int lineCount = 1;
+    int64_t position = 0;
+
+    uint64_t messages = 0; // Messages answered since the last reset
+
+    /**
+     * @brief Takes the answer of a recorded session as the new state, see
+     * NotificationTrace.hpp
+     * @return false if the message is not one the stub answers
+     */
+    bool Answer(unsigned message, int64_t value);
+    bool Text(unsigned message, const std::string& utf8);
+};
+
+extern FakeEditor fakeEditor;
+extern NppData nppData;
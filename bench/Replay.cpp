@@ -0,0 +1,514 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// DiscordRPC_replay: runs a session trace recorded by the plugin ("Record
+// session trace" menu command) through the update path of RichPresence,
+// with NppStub answering as the recorded editor did and FakeDiscordServer
+// standing in for Discord.
+//
+// Usage: DiscordRPC_replay <trace> [--json] [--realtime]
+// The notifications run back to back on a virtual clock, with --realtime
+// they keep the recorded pauses. With --json the report is one JSON object.
+
+#include "DiscordRichPresence.hpp"
+#include "FakeDiscordServer.hpp"
+#include "Metrics.hpp"
+#include "NotificationTrace.hpp"
+#include "NppStub.hpp"
+#include "PluginResources.h"
+#include "PresenceResolver.hpp"
+#include "TextEditorInfo.h"
+#include "UpdateScheduler.h"
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int64_t CLIENT_ID = 1234567890;
+    constexpr std::chrono::seconds WAIT_LIMIT{ 5 };
+
+    // Options of the recorded session, the defaults of ConfigManager for
+    // the ones the trace does not have
+    struct ReplayConfig
+    {
+        std::string detailsFormat = DEF_DETAILS_FORMAT;
+        std::string stateFormat = DEF_STATE_FORMAT;
+        std::string largeTextFormat = DEF_LARGE_TEXT_FORMAT;
+        bool hideDetails = false;
+        bool hideState = false;
+        bool langImage = true;
+        bool hideIfPrivate = false;
+        bool buttonRepository = false;
+        bool hideIdleStatus = false;
+        uint64_t refreshTime = DEF_REFRESH_TIME;
+        int idleTime = DEF_IDLE_TIME;
+        int heartbeatInterval = DEF_HEARTBEAT_INTERVAL;
+
+        void Set(const std::string& name, const std::string& value)
+        {
+            if (name == "detailsFormat")         detailsFormat = value;
+            else if (name == "stateFormat")      stateFormat = value;
+            else if (name == "largeTextFormat")  largeTextFormat = value;
+            else if (name == "hideDetails")      hideDetails = value == "true";
+            else if (name == "hideState")        hideState = value == "true";
+            else if (name == "langImage")        langImage = value == "true";
+            else if (name == "hideIfPrivate")    hideIfPrivate = value == "true";
+            else if (name == "buttonRepository") buttonRepository = value == "true";
+            else if (name == "hideIdleStatus")   hideIdleStatus = value == "true";
+            else if (name == "refreshTime")      refreshTime = std::stoull(value);
+            else if (name == "idleTime")         idleTime = std::stoi(value);
+            else if (name == "heartbeatInterval") heartbeatInterval = std::stoi(value);
+        }
+    };
+
+    // A notification and the answers the editor gave until the next one
+    struct TraceEvent
+    {
+        uint64_t time;
+        unsigned code;
+        std::vector<TraceRecord> answers;
+    };
+
+    struct ReplayStats
+    {
+        uint64_t notifications = 0; // Notifications that change the presence
+        uint64_t ignored = 0;       // Notifications without an UpdateReason
+        uint64_t answers = 0;
+        uint64_t unknownAnswers = 0;
+        uint64_t duration = 0;      // Recorded milliseconds
+    };
+
+    void ReadTrace(const char* path, ReplayConfig& config, std::vector<TraceEvent>& events)
+    {
+        std::ifstream in(path);
+        if (!in)
+            throw std::runtime_error(std::string("cannot open ") + path);
+
+        TraceReader reader(in);
+        TraceRecord record;
+        while (reader.Next(record))
+        {
+            switch (record.kind)
+            {
+            case TraceRecord::CONFIG:
+                config.Set(record.name, record.text);
+                break;
+            case TraceRecord::NOTIFICATION:
+                events.push_back({ record.time, record.code, {} });
+                break;
+            default:
+                // Answers recorded before the first notification belong to
+                // the update that started the recording
+                if (events.empty())
+                    events.push_back({ 0, 0, {} });
+                events.back().answers.push_back(record);
+                break;
+            }
+        }
+    }
+
+    /**
+     * Editor side of the plugin: the scheduler, TextEditorInfo and the
+     * options of RichPresence::Update, which posts to the resolver. The
+     * flush timer of ScheduleUpdate is a deadline on the trace clock
+     */
+    class ReplayEditor
+    {
+    public:
+        ReplayEditor(const ReplayConfig& config, PresenceResolver& resolver)
+            : _resolver(resolver)
+        {
+            _details.Compile(config.detailsFormat.c_str());
+            _state.Compile(config.stateFormat.c_str());
+            _largeText.Compile(config.largeTextFormat.c_str());
+
+            _options.details = &_details;
+            _options.state = &_state;
+            _options.largeText = &_largeText;
+            _options.hideDetails = config.hideDetails;
+            _options.hideState = config.hideState;
+            _options.langImage = config.langImage;
+            _options.hideIfPrivate = config.hideIfPrivate;
+            _options.buttonRepository = config.buttonRepository;
+            _options.hideIdleStatus = config.hideIdleStatus;
+            _query = MakeEditorQuery(_options);
+
+            _scheduler.SetInterval(config.refreshTime);
+        }
+
+        /**
+         * @brief Same as ScheduleUpdate in PluginDefinition.cpp
+         * @return true if a snapshot was posted to the resolver
+         */
+        bool Notify(unsigned reasons, uint64_t now)
+        {
+            if (_scheduler.Notify(reasons, now))
+            {
+                _scheduler.SetFlushArmed(false);
+                return RunScheduledUpdate(now);
+            }
+            if (!_scheduler.IsFlushArmed())
+            {
+                _flushAt = now + _scheduler.FlushDelay(now);
+                _scheduler.SetFlushArmed(true);
+            }
+            return false;
+        }
+
+        bool IsFlushDue(uint64_t now) const noexcept { return IsFlushArmed() && _flushAt <= now; }
+        bool IsFlushArmed() const noexcept { return _scheduler.IsFlushArmed(); }
+        uint64_t FlushTime() const noexcept { return _flushAt; }
+
+        bool Flush(uint64_t now)
+        {
+            _scheduler.SetFlushArmed(false);
+            return RunScheduledUpdate(now);
+        }
+
+        const UpdateSchedulerStats& GetStats() const noexcept { return _scheduler.GetStats(); }
+
+    private:
+        PresenceResolver& _resolver;
+        FormatProgram _details, _state, _largeText;
+        PresenceOptions _options;
+        EditorQuery _query;
+        TextEditorInfo _editorInfo;
+        EditorSnapshot _snapshot;
+        UpdateScheduler _scheduler;
+        uint64_t _flushAt = 0;
+
+        // RichPresence::Update, without the config snapshot of ConfigManager
+        bool RunScheduledUpdate(uint64_t now)
+        {
+            const unsigned reasons = _scheduler.TakeDirty(now);
+            if (reasons == UPDATE_NONE)
+                return false;
+
+            ScopedTimer timer(STAGE_UPDATE);
+            _editorInfo.LoadEditorStatus(reasons, _query);
+            _editorInfo.CaptureSnapshot(_snapshot);
+            ApplyPresenceOptions(_options, _query, _snapshot);
+            _resolver.Post(_snapshot);
+            return true;
+        }
+    };
+
+    void Apply(const TraceEvent& event, ReplayStats& stats)
+    {
+        for (const TraceRecord& answer : event.answers)
+        {
+            const bool known = answer.kind == TraceRecord::TEXT ?
+                fakeEditor.Text(answer.code, answer.text) : fakeEditor.Answer(answer.code, answer.value);
+            stats.answers++;
+            if (!known)
+                stats.unknownAnswers++;
+        }
+    }
+
+    /**
+     * @brief Waits until the snapshot posted last is resolved and Discord
+     * answered its presence, or the connection found it unchanged
+     * @details On the trace clock the notifications follow each other at
+     * once, waiting keeps every update as separate as it was in the
+     * recorded session
+     */
+    void Settle(const PresenceResolver& resolver, const DiscordRichPresence& drp)
+    {
+        const auto limit = Clock::now() + WAIT_LIMIT;
+        for (;;)
+        {
+            const PresenceResolverStats pending = resolver.GetStats();
+            const DiscordIPCStats ipc = drp.GetStats();
+            // One frame is the READY event of the handshake
+            const uint64_t answers = ipc.framesReceived - 1 - ipc.pongsReceived - ipc.pingsAnswered;
+            if (pending.posted == pending.resolved + pending.dropped &&
+                ipc.activitiesSent + ipc.activitiesSkipped >= pending.resolved &&
+                answers >= ipc.activitiesSent)
+                return;
+            if (Clock::now() > limit)
+                throw std::runtime_error("the update did not reach the fake Discord server");
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+
+    bool SameStats(const DiscordIPCStats& a, const DiscordIPCStats& b)
+    {
+        return a.framesSent == b.framesSent && a.framesReceived == b.framesReceived &&
+            a.activitiesSent == b.activitiesSent && a.activitiesSkipped == b.activitiesSkipped;
+    }
+
+    /**
+     * @brief Waits until the resolver took every snapshot and the
+     * connection stopped sending, the last presence has been answered
+     */
+    void Drain(const PresenceResolver& resolver, const DiscordRichPresence& drp)
+    {
+        constexpr std::chrono::milliseconds POLL{ 25 };
+        constexpr int STABLE_POLLS = 8;
+
+        const auto limit = Clock::now() + WAIT_LIMIT;
+        DiscordIPCStats last = drp.GetStats();
+        int stable = 0;
+        while (stable < STABLE_POLLS && Clock::now() < limit)
+        {
+            std::this_thread::sleep_for(POLL);
+            const PresenceResolverStats pending = resolver.GetStats();
+            const DiscordIPCStats current = drp.GetStats();
+            const bool idle = pending.posted == pending.resolved + pending.dropped &&
+                current.framesReceived >= current.activitiesSent;
+            stable = idle && SameStats(last, current) ? stable + 1 : 0;
+            last = current;
+        }
+    }
+
+    double Microseconds(uint64_t ns)
+    {
+        return static_cast<double>(ns) / 1000.0;
+    }
+
+    void PrintJson(const char* path, const ReplayStats& replay, const UpdateSchedulerStats& scheduler,
+        const PresenceResolverStats& resolver, const DiscordIPCStats& ipc, const FakeDiscordStats& server,
+        const LatencySummary& presence, double wallMs)
+    {
+        const LatencySummary event = Metrics::Summarize(STAGE_NOTIFY);
+        nlohmann::json report = {
+            { "trace", path },
+            { "notifications", replay.notifications },
+            { "ignored", replay.ignored },
+            { "answers", replay.answers },
+            { "recorded_ms", replay.duration },
+            { "wall_ms", wallMs },
+            { "immediate", scheduler.immediate },
+            { "deferred", scheduler.received - scheduler.immediate - scheduler.merged },
+            { "merged", scheduler.merged },
+            { "updates", scheduler.processed },
+            { "updates_flushed", scheduler.processed - scheduler.immediate },
+            { "resolved", resolver.resolved },
+            { "resolver_dropped", resolver.dropped },
+            { "workspace_loads", resolver.workspaceLoads },
+            { "activities_sent", ipc.activitiesSent },
+            { "activities_skipped", ipc.activitiesSkipped },
+            { "activities_received", server.activities },
+            { "bytes_sent", ipc.bytesSent },
+            { "bytes_received", ipc.bytesReceived },
+            { "event_p50_us", Microseconds(event.p50Ns) },
+            { "event_p90_us", Microseconds(event.p90Ns) },
+            { "event_p99_us", Microseconds(event.p99Ns) },
+            { "event_max_us", Microseconds(event.maxNs) },
+            { "presence_p50_us", Microseconds(presence.p50Ns) },
+            { "presence_p99_us", Microseconds(presence.p99Ns) },
+            { "presence_max_us", Microseconds(presence.maxNs) }
+        };
+
+        nlohmann::json stages = nlohmann::json::object();
+        for (size_t stage = 0; stage < STAGE_COUNT; stage++)
+        {
+            const LatencySummary summary = Metrics::Summarize(static_cast<MetricStage>(stage));
+            if (summary.count == 0)
+                continue;
+            stages[METRIC_STAGE_NAMES[stage]] = {
+                { "count", summary.count },
+                { "p50_us", Microseconds(summary.p50Ns) },
+                { "p99_us", Microseconds(summary.p99Ns) },
+                { "max_us", Microseconds(summary.maxNs) }
+            };
+        }
+        report["stages"] = stages;
+        std::printf("%s\n", report.dump().c_str());
+    }
+
+    void PrintText(const char* path, const ReplayStats& replay, const UpdateSchedulerStats& scheduler,
+        const PresenceResolverStats& resolver, const DiscordIPCStats& ipc, const FakeDiscordStats& server,
+        const LatencySummary& presence, double wallMs)
+    {
+        const LatencySummary event = Metrics::Summarize(STAGE_NOTIFY);
+        std::printf(
+            "Replay of %s\n"
+            "  notifications      %llu, %llu ignored, %llu answers\n"
+            "  scheduled          %llu immediate, %llu deferred, %llu merged into a deferred update\n"
+            "  duration           %llu ms recorded, %.1f ms replayed\n"
+            "  updates            %llu, %llu immediate, %llu at the end of a window\n"
+            "  presences resolved %llu, %llu replaced before resolved\n"
+            "  workspace loads    %llu\n"
+            "  activities sent    %llu, %llu unchanged, %llu received by Discord\n"
+            "  bytes on the wire  %llu sent, %llu received\n"
+            "  event latency      p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n"
+            "  presence latency   p50 %.1f us, p99 %.1f us, max %.1f us%s\n"
+            "\n",
+            path,
+            (unsigned long long)replay.notifications, (unsigned long long)replay.ignored,
+            (unsigned long long)replay.answers,
+            (unsigned long long)scheduler.immediate,
+            (unsigned long long)(scheduler.received - scheduler.immediate - scheduler.merged),
+            (unsigned long long)scheduler.merged,
+            (unsigned long long)replay.duration, wallMs,
+            (unsigned long long)scheduler.processed, (unsigned long long)scheduler.immediate,
+            (unsigned long long)(scheduler.processed - scheduler.immediate),
+            (unsigned long long)resolver.resolved, (unsigned long long)resolver.dropped,
+            (unsigned long long)resolver.workspaceLoads,
+            (unsigned long long)ipc.activitiesSent, (unsigned long long)ipc.activitiesSkipped,
+            (unsigned long long)server.activities,
+            (unsigned long long)ipc.bytesSent, (unsigned long long)ipc.bytesReceived,
+            Microseconds(event.p50Ns), Microseconds(event.p90Ns),
+            Microseconds(event.p99Ns), Microseconds(event.maxNs),
+            Microseconds(presence.p50Ns), Microseconds(presence.p99Ns), Microseconds(presence.maxNs),
+            presence.count == 0 ? " (not measured with --realtime)" : "");
+
+        std::string stages;
+        Metrics::WriteReport(stages);
+        std::printf("%s", stages.c_str());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* path = nullptr;
+    bool json = false;
+    bool realtime = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (std::strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else
+            path = argv[i];
+    }
+    if (!path)
+    {
+        std::fprintf(stderr, "Usage: DiscordRPC_replay <trace> [--json] [--realtime]\n");
+        return 2;
+    }
+
+    try
+    {
+        ReplayConfig config;
+        std::vector<TraceEvent> events;
+        ReadTrace(path, config, events);
+
+        RuntimeDirectory directory;
+        FakeDiscordServer server(0, FakeDiscordScript{});
+
+        // Same wiring as RichPresence::InitializePresence
+        DiscordRichPresence drp;
+        if (!drp.Start(CLIENT_ID))
+            throw std::runtime_error("cannot start the IPC worker");
+        const auto connectLimit = Clock::now() + WAIT_LIMIT;
+        while (!drp.IsConnected() || drp.GetStats().framesReceived == 0)
+        {
+            if (Clock::now() > connectLimit)
+                throw std::runtime_error("the client did not connect to the fake Discord server");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        Presence idle;
+        idle.details = "Idling";
+        idle.largeText = NPP_NAME;
+        idle.largeImage = NPP_IDLEIMAGE;
+        drp.SetIdleStatus(config.hideIdleStatus ? nullptr : &idle, std::chrono::seconds(config.idleTime));
+        drp.SetHeartbeatInterval(std::chrono::seconds(config.heartbeatInterval));
+
+        PresenceResolver resolver;
+        if (!resolver.Start([&drp](const Presence& presence, bool isIdling) {
+                drp.PostPresence(presence, isIdling);
+            }))
+            throw std::runtime_error("cannot start the presence resolver");
+
+        Metrics::SetEnabled(true);
+        ReplayEditor editor(config, resolver);
+        ReplayStats stats;
+
+        // Editor notification until Discord answered the presence, only
+        // measured on the trace clock where the updates do not overlap
+        LatencyHistogram presenceLatency;
+        auto runUpdate = [&](auto&& update) {
+            const auto begin = Clock::now();
+            if (update() && !realtime)
+            {
+                Settle(resolver, drp);
+                presenceLatency.Record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count()));
+            }
+        };
+
+        const auto start = Clock::now();
+        auto waitFor = [&](uint64_t time) {
+            if (realtime)
+                std::this_thread::sleep_until(start + std::chrono::milliseconds(time));
+        };
+
+        for (const TraceEvent& event : events)
+        {
+            // The flush timer fires before the next notification
+            if (editor.IsFlushDue(event.time))
+            {
+                waitFor(editor.FlushTime());
+                runUpdate([&] { return editor.Flush(editor.FlushTime()); });
+            }
+            waitFor(event.time);
+
+            Apply(event, stats);
+            const unsigned reasons = NotificationReasons(event.code);
+            if (reasons == UPDATE_NONE)
+            {
+                stats.ignored++;
+                continue;
+            }
+
+            runUpdate([&] {
+                ScopedTimer timer(STAGE_NOTIFY);
+                return editor.Notify(reasons, event.time);
+            });
+            stats.notifications++;
+            stats.duration = event.time;
+        }
+        if (editor.IsFlushArmed())
+        {
+            waitFor(editor.FlushTime());
+            runUpdate([&] { return editor.Flush(editor.FlushTime()); });
+        }
+
+        Drain(resolver, drp);
+        const double wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        const PresenceResolverStats resolverStats = resolver.GetStats();
+        const DiscordIPCStats ipcStats = drp.GetStats();
+        const FakeDiscordStats serverStats = server.Stats();
+        if (json)
+            PrintJson(path, stats, editor.GetStats(), resolverStats, ipcStats, serverStats,
+                presenceLatency.Summarize(), wallMs);
+        else
+            PrintText(path, stats, editor.GetStats(), resolverStats, ipcStats, serverStats,
+                presenceLatency.Summarize(), wallMs);
+
+        resolver.Stop();
+        drp.Close();
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "DiscordRPC_replay: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+#include "ResponseScanner.hpp"
+#include "nlohmann/json.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+    // Answer of Discord to a SET_ACTIVITY, it echoes the whole activity
+    const std::string SUCCESS_RESPONSE = R"({"cmd":"SET_ACTIVITY","data":{"state":"Line 1204, column 17",)"
+        R"("details":"Editing: PresenceSerializer.cpp","timestamps":{"start":1760000000000},)"
+        R"("assets":{"large_image":"cpp","large_text":"Editing a C++ file","small_image":"notepadpp",)"
+        R"("small_text":"Notepad++"},"buttons":["View Repository"],"name":"Notepad++",)"
+        R"("application_id":"931200591349092372","type":0,"metadata":{"button_urls":)"
+        R"(["https://github.com/Zukaritasu/notepadpp_rpc"]},"flags":0},"evt":null,"nonce":"1204"})";
+
+    // The old handling: the evt and the nonce of the DOM
+    void ParseWithDom(const std::string& body, std::string& evt, std::string& nonce)
+    {
+        using json = nlohmann::json;
+        const json j = json::parse(body);
+        evt = j.contains("evt") && j["evt"].is_string() ? j["evt"].get<std::string>() : std::string();
+        nonce = j.contains("nonce") && j["nonce"].is_string() ? j["nonce"].get<std::string>() : std::string();
+    }
+
+    void CheckScanner()
+    {
+        const std::string valid[] = {
+            SUCCESS_RESPONSE,
+            R"({"cmd":"SET_ACTIVITY","data":{"code":4000,"message":"child \"activity\" fails"},"evt":"ERROR","nonce":"7"})",
+            R"( { "nonce" : "8" , "evt" : "ERROR" , "data" : { "nonce" : "nested" } } )",
+            R"({"data":[1,[2,{"evt":"no"}],"]}"],"nonce":"9"})",
+            R"({"nonce":"a\"b\\","evt":null})",
+            R"({"nonce":10,"evt":true})",
+            R"({"nonce":"11","nonce":"12"})",
+            R"({"nonce":"13","nonce":null})",
+            R"({"x":-1.5e3,"y":false,"nonce":"14"})",
+            R"({})"
+        };
+        for (const std::string& body : valid)
+        {
+            std::string evt, nonce;
+            ParseWithDom(body, evt, nonce);
+
+            DiscordResponse response;
+            // Escapes are not decoded, the nonces of the plugin have none
+            const bool escaped = nonce.find_first_of("\"\\") != std::string::npos;
+            if (!ScanResponse(body, response) || response.evt != evt ||
+                (!escaped && response.nonce != nonce))
+            {
+                throw std::runtime_error("response: scanner differs from nlohmann::json for " + body);
+            }
+        }
+
+        const char* const invalid[] = {
+            "", "[]", "\"nonce\"", "{", R"({"nonce":"1")", R"({"nonce" "1"})",
+            R"({"nonce":"1",})", R"({"nonce":"1"} x)", R"({"data":{"a":1})", R"({"nonce":"1\"})"
+        };
+        for (const char* body : invalid)
+        {
+            DiscordResponse response;
+            if (ScanResponse(body, response))
+                throw std::runtime_error(std::string("response: scanner accepted ") + body);
+        }
+    }
+}
+
+void RunResponseBench(Bench& bench)
+{
+    if (bench.Enabled("response/scanner_equivalence"))
+    {
+        CheckScanner();
+        bench.Report("response/scanner_equivalence", { { "equal", 1 } }, "%s",
+            "scanner agrees with nlohmann::json");
+    }
+
+    std::string evt, nonce;
+    bench.Run("response/nlohmann_dom/success", [&] {
+        ParseWithDom(SUCCESS_RESPONSE, evt, nonce);
+        Bench::Consume(nonce);
+    });
+
+    DiscordResponse response;
+    bench.Run("response/scan/success", [&] {
+        ScanResponse(SUCCESS_RESPONSE, response);
+        Bench::Consume(response);
+    });
+
+    if (bench.Enabled("response/"))
+    {
+        constexpr int RESPONSES = 1000;
+        uint64_t before = AllocationCount();
+        for (int i = 0; i < RESPONSES; i++)
+            ParseWithDom(SUCCESS_RESPONSE, evt, nonce);
+        const uint64_t dom = AllocationCount() - before;
+
+        before = AllocationCount();
+        for (int i = 0; i < RESPONSES; i++)
+            ScanResponse(SUCCESS_RESPONSE, response);
+        const uint64_t scan = AllocationCount() - before;
+
+        const double domPerOp = static_cast<double>(dom) / RESPONSES;
+        const double scanPerOp = static_cast<double>(scan) / RESPONSES;
+        bench.Report("response/allocations", { { "nlohmann_dom", domPerOp }, { "scan", scanPerOp } },
+            "nlohmann_dom %.1f, scan %.1f allocations/op", domPerOp, scanPerOp);
+    }
+}
@@ -0,0 +1,246 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+#include "PresenceSerializer.hpp"
+#include "nlohmann/json.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned long PID = 4242;
+
+    /**
+     * The serialization before the fragments were cached: a nlohmann::json
+     * DOM built for every command. The old dump threw on invalid UTF-8, it
+     * is compared with the replacement the writer does instead; for valid
+     * UTF-8 both dumps are the same.
+     */
+    std::string LegacyPresenceToJson(const Presence& presence, const std::string& nonce)
+    {
+        using json = nlohmann::json;
+        constexpr size_t MIN_STRING_LENGTH = PresenceSerializer::MIN_STRING_LENGTH;
+
+        json j;
+        j["cmd"] = "SET_ACTIVITY";
+        j["nonce"] = nonce;
+
+        auto& args = j["args"];
+        args["pid"] = PID;
+
+        auto& activity = args["activity"];
+
+        if (presence.state.size() >= MIN_STRING_LENGTH)
+            activity["state"] = presence.state;
+
+        if (presence.details.size() >= MIN_STRING_LENGTH)
+            activity["details"] = presence.details;
+
+        if (presence.startTime > 0)
+        {
+            activity["timestamps"]["start"] = presence.startTime;
+            if (presence.endTime > 0)
+                activity["timestamps"]["end"] = presence.endTime;
+        }
+
+        json assets = json::object();
+        if (!presence.largeImage.empty())
+            assets["large_image"] = presence.largeImage;
+        if (presence.largeText.size() >= MIN_STRING_LENGTH)
+            assets["large_text"] = presence.largeText;
+        if (!presence.smallImage.empty())
+            assets["small_image"] = presence.smallImage;
+        if (presence.smallText.size() >= MIN_STRING_LENGTH)
+            assets["small_text"] = presence.smallText;
+
+        if (!assets.empty())
+            activity["assets"] = assets;
+
+        if (presence.enableButtonRepository && !presence.repositoryUrl.empty())
+        {
+            activity["buttons"] = json::array({
+                {{"label", "View Repository"}, {"url", presence.repositoryUrl}}
+            });
+        }
+
+        return j.dump(-1, ' ', false, json::error_handler_t::replace);
+    }
+
+    Presence MakePresence(int line)
+    {
+        Presence p;
+        p.SetText(Presence::FIELD_DETAILS, "Editing: PresenceSerializer.cpp");
+        p.SetText(Presence::FIELD_STATE, "Line " + std::to_string(line) + ", column 17");
+        p.SetText(Presence::FIELD_LARGE_IMAGE, "cpp");
+        p.SetText(Presence::FIELD_LARGE_TEXT, "Editing a C++ file");
+        p.SetText(Presence::FIELD_SMALL_IMAGE, "notepadpp");
+        p.SetText(Presence::FIELD_SMALL_TEXT, "Notepad++");
+        p.SetText(Presence::FIELD_REPOSITORY_URL, "https://github.com/Zukaritasu/notepadpp_rpc");
+        p.enableButtonRepository = true;
+        p.startTime = 1760000000;
+        return p;
+    }
+
+    // Presences that cover every optional member and every escape
+    std::vector<Presence> MakeCorpus()
+    {
+        std::vector<Presence> corpus;
+        corpus.push_back(MakePresence(1));
+        corpus.emplace_back(); // null activity
+
+        Presence p;
+        p.details = "Quote \" backslash \\ slash / tab \t newline \n cr \r";
+        p.state = std::string("Controls \x01\x08\x0c\x1f del \x7f end", 33);
+        p.largeText = "UTF-8: \xc3\xb1" "and\xc3\xba \xe2\x82\xac \xf0\x9f\x98\x80";
+        p.smallText = "x"; // too short, left out
+        p.startTime = 1;
+        p.endTime = 9000000000;
+        corpus.push_back(p);
+
+        Presence assetsOnly;
+        assetsOnly.smallImage = "notepadpp";
+        corpus.push_back(assetsOnly);
+
+        Presence button;
+        button.repositoryUrl = "https://example.com/a\"b";
+        button.enableButtonRepository = true;
+        corpus.push_back(button);
+
+        Presence noButton = button;
+        noButton.enableButtonRepository = false;
+        noButton.details = "ab";
+        corpus.push_back(noButton);
+
+        // Invalid UTF-8: stray continuation, overlong forms, a surrogate,
+        // code points above U+10FFFF and truncated sequences
+        const char* const invalid[] = {
+            "a\x80" "b", "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80",
+            "\xf5\x80", "ab\xe2\x82", "ab\xf0\x9f\x98", "\xe2\x82" "a\xc3", "\xff\xfe",
+            "\xe2\x28\xa1", "\xf0\x9f\x98\x80\xf0\x9f"
+        };
+        for (const char* text : invalid)
+        {
+            Presence broken;
+            broken.state = text;
+            broken.smallImage = text;
+            broken.repositoryUrl = text;
+            broken.enableButtonRepository = true;
+            corpus.push_back(broken);
+        }
+        return corpus;
+    }
+}
+
+void RunSerializeBench(Bench& bench)
+{
+    PresenceSerializer serializer;
+    std::string frame;
+
+    // The commands must not change with the serializer
+    if (bench.Enabled("serialize/nlohmann_equivalence"))
+    {
+        size_t checked = 0;
+        for (int pass = 0; pass < 2; pass++) // The second pass comes from the cache
+        {
+            for (const Presence& presence : MakeCorpus())
+            {
+                const std::string nonce = "nonce-" + std::to_string(checked);
+                const std::string expected = LegacyPresenceToJson(presence, nonce);
+                frame.clear();
+                serializer.Serialize(frame, presence, nonce, PID);
+                if (frame != expected)
+                {
+                    throw std::runtime_error("serialize: output differs from nlohmann::json\n  expected: " +
+                        expected + "\n  actual:   " + frame);
+                }
+                checked++;
+            }
+        }
+        bench.Report("serialize/nlohmann_equivalence", { { "checked", static_cast<double>(checked) } },
+            "%zu commands equal to nlohmann::json", checked);
+    }
+
+    // The line changes with every update, the texts are made beforehand so
+    // only the serialization is measured
+    std::vector<std::string> states;
+    for (int line = 1; line <= 64; line++)
+        states.push_back("Line " + std::to_string(line * 1000) + ", column 17");
+    size_t next = 0;
+    const auto changeState = [&](Presence& presence) {
+        presence.SetText(Presence::FIELD_STATE, states[next++ % states.size()]);
+    };
+
+    // Allocations per command once the buffers have grown
+    const auto reportAllocations = [&](const char* name, Presence& presence, bool change) {
+        if (!bench.Enabled(name))
+            return;
+        constexpr int COMMANDS = 1000;
+        const uint64_t before = AllocationCount();
+        for (int i = 0; i < COMMANDS; i++)
+        {
+            if (change)
+                changeState(presence);
+            frame.clear();
+            serializer.Serialize(frame, presence, "17", PID);
+        }
+        const double perOp = static_cast<double>(AllocationCount() - before) / COMMANDS;
+        bench.Report(name, { { "allocations_per_op", perOp } }, "%.2f allocations/op", perOp);
+    };
+
+    Presence presence = MakePresence(1);
+    bench.Run("serialize/nlohmann_dom/state_changed", [&] {
+        changeState(presence);
+        std::string json = LegacyPresenceToJson(presence, "17");
+        Bench::Consume(json);
+    });
+
+    bench.Run("serialize/fragments/state_changed", [&] {
+        changeState(presence);
+        frame.clear();
+        serializer.Serialize(frame, presence, "17", PID);
+        Bench::Consume(frame);
+    });
+    reportAllocations("serialize/fragments/state_changed", presence, true);
+
+    bench.Run("serialize/fragments/unchanged", [&] {
+        frame.clear();
+        serializer.Serialize(frame, presence, "17", PID);
+        Bench::Consume(frame);
+    });
+    reportAllocations("serialize/fragments/unchanged", presence, false);
+
+    // Without revisions every field is compared by value
+    Presence plain = MakePresence(1);
+    for (uint64_t& revision : plain.revisions)
+        revision = 0;
+    bench.Run("serialize/fragments/unchanged_no_revisions", [&] {
+        frame.clear();
+        serializer.Serialize(frame, plain, "17", PID);
+        Bench::Consume(frame);
+    });
+
+    // Escaping and UTF-8 validation of a whole presence, nothing cached
+    Presence unicode = MakePresence(1);
+    unicode.SetText(Presence::FIELD_DETAILS, "Editing: \xc3\xb1" "and\xc3\xba.cpp \xe2\x80\x94 \"quoted\"");
+    unicode.SetText(Presence::FIELD_LARGE_TEXT, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e \xf0\x9f\x98\x80");
+    bench.Run("serialize/escape/utf8", [&] {
+        frame.clear();
+        for (int field = 0; field < Presence::FIELD_COUNT; field++)
+            PresenceSerializer::AppendEscaped(frame, unicode.Text(static_cast<Presence::Field>(field)));
+        Bench::Consume(frame);
+    });
+}
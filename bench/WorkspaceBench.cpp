@@ -0,0 +1,115 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Bench.hpp"
+#include "DeepTree.hpp"
+#include "FileFilter.hpp"
+#include "PresenceResolver.hpp"
+#include "WorkspaceCache.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+    const char* const DETAILS = "Editing: %(file)";
+    const char* const STATE = "Workspace: %(workspace)";
+    const char* const LARGE_TEXT = "Editing a %(LANG) file";
+
+    // Cases that need the tree, it is only built if one of them runs
+    const char* const CASES[] =
+    {
+        "workspace/repository_url", "workspace/lookup/cold", "workspace/lookup/warm",
+        "workspace/select/deep", "workspace/is_private/deep",
+        "workspace/resolve/buffer_switch", "workspace/resolve/typing"
+    };
+}
+
+void RunWorkspaceBench(Bench& bench)
+{
+    bool enabled = false;
+    for (const char* name : CASES)
+        enabled = enabled || bench.Enabled(name);
+    if (!enabled)
+        return;
+
+    const DeepTree tree;
+    const std::string& leaf = tree.Directories().back();
+    const std::vector<std::string>& files = tree.Files();
+
+    // The origin remote comes after several other remotes and branches
+    const std::string config = std::string(DISCORDRPC_BENCH_CORPUS) + "/git_config";
+    std::string url;
+    WorkspaceCache::ReadRepositoryUrl(config, url);
+    if (url != "https://github.com/Zukaritasu/notepadpp_rpc.git")
+        throw std::runtime_error("workspace/repository_url: read \"" + url + "\"");
+
+    bench.Run("workspace/repository_url", [&] {
+        WorkspaceCache::ReadRepositoryUrl(config, url);
+        Bench::Consume(url);
+    });
+
+    // A new directory searches every level up to the repository root
+    WorkspaceCache cache;
+    bench.Run("workspace/lookup/cold", [&] {
+        cache.Clear();
+        Bench::Consume(cache.Lookup(leaf));
+    });
+
+    bench.Run("workspace/lookup/warm", [&] {
+        Bench::Consume(cache.Lookup(leaf));
+    });
+
+    // Every level of the tree is checked by its fingerprint
+    FileFilter filter;
+    filter.SelectDirectory(leaf, tree.Root(), true);
+    bench.Run("workspace/select/deep", [&] {
+        filter.SelectDirectory(leaf, tree.Root(), true);
+        Bench::Consume(filter);
+    });
+
+    size_t index = 0;
+    bench.Run("workspace/is_private/deep", [&] {
+        bool result = filter.IsPrivate(files[index++ % files.size()]);
+        Bench::Consume(result);
+    });
+
+    // The resolver stage of an update. A buffer switch resolves the
+    // workspace and the privacy again, typing only renders the formats
+    const FormatProgram details(DETAILS), state(STATE), largeText(LARGE_TEXT);
+    EditorSnapshot snapshot;
+    snapshot.details = &details;
+    snapshot.state = &state;
+    snapshot.largeText = &largeText;
+    snapshot.hideIfPrivate = true;
+    snapshot.buttonRepository = true;
+    snapshot.workspace = true;
+    snapshot.directory = leaf;
+    snapshot.fileName = "main.cpp";
+    snapshot.largeImage = "cpp";
+    snapshot.props[TOKEN_FILE] = "main.cpp";
+    snapshot.props[TOKEN_LANG_UPPER] = "C++";
+
+    PresenceResolver resolver;
+    bench.Run("workspace/resolve/buffer_switch", [&] {
+        snapshot.buffer++;
+        Bench::Consume(resolver.Resolve(snapshot));
+    });
+
+    int column = 1;
+    bench.Run("workspace/resolve/typing", [&] {
+        snapshot.props[TOKEN_COLUMN] = std::to_string(column++ % 120);
+        Bench::Consume(resolver.Resolve(snapshot));
+    });
+}
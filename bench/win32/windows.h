@@ -0,0 +1,63 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+// The part of the Win32 API that the editor sources of the plugin use, so
+// TextEditorInfo and LanguageInfo build on other platforms. The functions
+// are implemented by NppStub.cpp, which plays the role of Notepad++
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+
+#define __int64 int64_t
+#define __cdecl
+#define CALLBACK
+
+typedef void* HWND;
+typedef void* HBITMAP;
+typedef void* HICON;
+typedef void* HMENU;
+typedef void* HINSTANCE;
+typedef int BOOL;
+typedef unsigned char UCHAR;
+typedef unsigned short WORD;
+typedef unsigned int UINT;
+typedef unsigned long DWORD;
+typedef long LONG;
+typedef long long LONGLONG;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+typedef wchar_t WCHAR;
+typedef wchar_t TCHAR;
+typedef TCHAR* LPTSTR;
+typedef const TCHAR* LPCTSTR;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define CP_UTF8 65001
+#define WM_USER 0x400
+#define TEXT(x) L##x
+
+int WideCharToMultiByte(UINT codePage, DWORD flags, LPCWSTR wide, int wideLength,
+    LPSTR multiByte, int multiByteLength, LPCSTR defaultChar, BOOL* usedDefaultChar);
@@ -0,0 +1,113 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "ConfigWatcher.h"
+#include "PluginConfig.h"
+#include "PluginDefinition.h"
+
+#include <Shlwapi.h>
+
+extern ConfigManager configManager;
+
+bool ConfigWatcher::Start(const std::wstring& configPath) noexcept
+{
+	if (_thread)
+		return true;
+
+	try
+	{
+		_path = configPath;
+		std::wstring directory = configPath;
+		::PathRemoveFileSpecW(directory.data());
+		directory.resize(wcslen(directory.c_str()));
+
+		// Other plugins keep their files in the same directory, FileChanged
+		// filters their changes out
+		_change = ::FindFirstChangeNotificationW(directory.c_str(), FALSE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+		if (_change == INVALID_HANDLE_VALUE)
+			return false;
+
+		FileChanged(); // The config that was just loaded
+		_thread = std::make_unique<BasicThread>(Run, this);
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		Stop();
+		return false;
+	}
+}
+
+void ConfigWatcher::Stop() noexcept
+{
+	_thread.reset();
+	if (_change != INVALID_HANDLE_VALUE)
+	{
+		::FindCloseChangeNotification(_change);
+		_change = INVALID_HANDLE_VALUE;
+	}
+}
+
+void ConfigWatcher::Run(void* data, const StopToken& stopToken)
+{
+	ConfigWatcher* watcher = static_cast<ConfigWatcher*>(data);
+	const HANDLE handles[2] = { stopToken.GetHandle(), watcher->_change };
+
+	while (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+	{
+		// Every further change restarts the settle time
+		DWORD result;
+		do
+		{
+			if (!::FindNextChangeNotification(watcher->_change))
+				return;
+			result = ::WaitForMultipleObjects(2, handles, FALSE, SETTLE_TIME_MS);
+		} while (result == WAIT_OBJECT_0 + 1);
+
+		if (result != WAIT_TIMEOUT)
+			return;
+		if (watcher->FileChanged())
+			watcher->Reload();
+	}
+}
+
+bool ConfigWatcher::FileChanged() noexcept
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesExW(_path.c_str(), GetFileExInfoStandard, &attributes))
+		return false; // Deleted or being replaced, the current config stays
+
+	if (::CompareFileTime(&attributes.ftLastWriteTime, &_lastWrite) == 0)
+		return false;
+	_lastWrite = attributes.ftLastWriteTime;
+	return true;
+}
+
+void ConfigWatcher::Reload() noexcept
+{
+	try
+	{
+		// Saving the options dialog also writes the file, it reloads the
+		// current config and publishes nothing
+		if (configManager.ReloadConfig(_path))
+			_reloaded.store(true, std::memory_order_release);
+	}
+	catch (const std::exception& e)
+	{
+		QueueErrorMessage(std::string("The changes to " PLUGIN_CONFIG_FILENAME
+			" were not applied, the previous configuration is kept.\n\n") + e.what());
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "PluginThread.h"
+
+/**
+ * Watches the configuration file and reloads it on a background thread when
+ * it changes on disk. A valid file is published as a new ConfigManager
+ * snapshot at once; what depends on the connection or the editor is applied
+ * by the UI thread, which polls TakeReloaded. An invalid file keeps the
+ * current config and queues an error message.
+ */
+class ConfigWatcher
+{
+public:
+	ConfigWatcher() = default;
+	ConfigWatcher(const ConfigWatcher&) = delete;
+	ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+	~ConfigWatcher() { Stop(); }
+
+	/**
+	 * @brief Starts watching the directory of the file
+	 * @return false if the directory cannot be watched, the file is then
+	 * only read when Notepad++ starts
+	 */
+	bool Start(const std::wstring& configPath) noexcept;
+	void Stop() noexcept;
+
+	/**
+	 * @brief true once for every reload that published a new config
+	 */
+	bool TakeReloaded() noexcept { return _reloaded.exchange(false, std::memory_order_acquire); }
+
+private:
+	// Editors save in several writes, the file is read once it was quiet
+	// for this time
+	static constexpr DWORD SETTLE_TIME_MS = 200;
+
+	std::wstring _path;
+	HANDLE _change = INVALID_HANDLE_VALUE;
+	FILETIME _lastWrite{};
+	std::atomic<bool> _reloaded{ false };
+	std::unique_ptr<BasicThread> _thread;
+
+	static void Run(void* data, const StopToken& stopToken);
+	bool FileChanged() noexcept;
+	void Reload() noexcept;
+};
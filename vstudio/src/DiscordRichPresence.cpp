@@ -17,17 +17,69 @@
 #include <iostream>
 #include <sstream>
 #include <chrono>
-#include <random>
+#include <cstring>
+#include <algorithm>
+#include "Metrics.hpp"
+#include "ResponseScanner.hpp"
 #include "nlohmann/json.hpp"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    unsigned long currentProcessId() noexcept
+    {
+#ifdef _WIN32
+        return ::GetCurrentProcessId();
+#else
+        return static_cast<unsigned long>(::getpid());
+#endif
+    }
+
+    int64_t unixTimeSeconds() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    uint32_t remainingMilliseconds(std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (deadline <= now)
+            return 0;
+        return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+    }
+}
 
 DiscordRichPresence::DiscordRichPresence() noexcept
-    : m_pipe(INVALID_HANDLE_VALUE), m_connected(false)
+    : DiscordRichPresence(nullptr)
+{
+    try
+    {
+        m_transport = IpcTransport::CreateDefault();
+    }
+    catch (const std::bad_alloc &)
+    {
+        // Start fails without a transport
+    }
+}
+
+DiscordRichPresence::DiscordRichPresence(std::unique_ptr<IpcTransport> transport) noexcept
+    : m_transport(std::move(transport)), m_stopping(false), m_connected(false), m_standby(false),
+      m_heartbeatSeconds(DEFAULT_HEARTBEAT_INTERVAL.count()), m_sessionStart(0)
 {
-    m_lastUpdateTime.store(std::chrono::duration_cast<std::chrono::seconds>(
-                               std::chrono::system_clock::now().time_since_epoch())
-                               .count());
+    m_lastActivity.store(Clock::now().time_since_epoch().count());
+    m_frame.reserve(FRAME_BUFFER_SIZE);
+    m_inFlight.reserve(MAX_IN_FLIGHT + 1); // The clear activity may follow them
 }
 
 DiscordRichPresence::~DiscordRichPresence()
@@ -35,383 +87,662 @@ DiscordRichPresence::~DiscordRichPresence()
     Close();
 }
 
-/**
- * @brief Converts a Presence structure to a JSON string
- * @param presence The presence data to convert
- * @return JSON string representing the presence
- */
-std::string DiscordRichPresence::presenceToJson(const Presence &presence)
+std::string DiscordRichPresence::generateNonce()
 {
-    json j;
-    j["cmd"] = "SET_ACTIVITY";
-    j["nonce"] = generateNonce();
-
-    auto &args = j["args"];
-    args["pid"] = ::GetCurrentProcessId();
+    // Unique for the lifetime of the process, responses are matched by it
+    return std::to_string(++m_nonceCounter);
+}
 
-    auto &activity = args["activity"];
+bool DiscordRichPresence::connectToDiscord(int64_t clientId)
+{
+    disconnect();
 
-    if (presence.state.size() >= MIN_STRING_LENGTH)
-        activity["state"] = presence.state;
+    // Only the endpoints that exist are opened, the endpoint that worked
+    // last time first since Discord usually keeps it
+    const uint32_t endpoints = m_transport->ProbeEndpoints();
+    if (endpoints == 0)
+    {
+        if (!m_absenceReported)
+            Report("Could not connect to Discord. Is Discord running?");
+        m_absenceReported = true;
+        return false;
+    }
 
-    if (presence.details.size() >= MIN_STRING_LENGTH)
-        activity["details"] = presence.details;
+    if (m_lastEndpoint >= 0 && (endpoints & (1u << m_lastEndpoint)) &&
+        connectToEndpoint(m_lastEndpoint, clientId))
+        return true;
 
-    if (presence.startTime > 0)
+    for (int i = 0; i < IpcTransport::MAX_ENDPOINTS; i++)
     {
-        activity["timestamps"]["start"] = presence.startTime;
-        if (presence.endTime > 0)
-            activity["timestamps"]["end"] = presence.endTime;
+        if (i != m_lastEndpoint && (endpoints & (1u << i)) && connectToEndpoint(i, clientId))
+            return true;
     }
+    // A handshake cut short by Close is not an absence of Discord
+    if (m_stopping)
+        return false;
+    if (!m_absenceReported)
+        Report("Could not connect to Discord. Is Discord running?");
+    m_absenceReported = true;
+    return false;
+}
 
-    json assets = json::object();
-    if (!presence.largeImage.empty())
-        assets["large_image"] = presence.largeImage;
-    if (presence.largeText.size() >= MIN_STRING_LENGTH)
-        assets["large_text"] = presence.largeText;
-    if (!presence.smallImage.empty())
-        assets["small_image"] = presence.smallImage;
-    if (presence.smallText.size() >= MIN_STRING_LENGTH)
-        assets["small_text"] = presence.smallText;
-
-    if (!assets.empty())
-        activity["assets"] = assets;
+bool DiscordRichPresence::connectToEndpoint(int index, int64_t clientId)
+{
+    if (!m_transport->Connect(index))
+        return false;
 
-    if (presence.enableButtonRepository && !presence.repositoryUrl.empty())
+    // The handshake is the only synchronous exchange. Discord answers it
+    // with the READY event, the frames it may send before are handled as
+    // usual; OP_CLOSE means that the client ID was rejected
+    std::string handshake = R"({"v":1,"client_id":")" + std::to_string(clientId) + R"("})";
+    m_ready = false;
+    const bool ready = sendFrame(OP_HANDSHAKE, handshake) &&
+        ReadUntil(Clock::now() + std::chrono::milliseconds(READ_TIMEOUT_MS), &DiscordRichPresence::IsReady);
+    if (!ready)
     {
-        activity["buttons"] = json::array({
-            {{"label", "View Repository"}, {"url", presence.repositoryUrl}}
-        });
+        disconnect();
+        return false;
     }
 
-    return j.dump();
+    m_connected = true;
+    m_connectedSince = Clock::now();
+    m_counters.connections.fetch_add(1, std::memory_order_relaxed);
+    m_lastEndpoint = index;
+    m_absenceReported = false;
+    int64_t expected = 0;
+    m_sessionStart.compare_exchange_strong(expected, unixTimeSeconds());
+    return true;
 }
 
-std::string DiscordRichPresence::generateNonce() const
+bool DiscordRichPresence::sendFrame(uint32_t opcode, std::string_view json)
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(100000, 999999);
+    beginFrame();
+    m_frame += json;
+    return writeFrame(opcode);
+}
 
-    return std::to_string(dis(gen));
+void DiscordRichPresence::beginFrame()
+{
+    // The header is filled in by writeFrame once the length is known
+    m_frame.assign(sizeof(DiscordIPCHeader), '\0');
 }
 
-std::string DiscordRichPresence::escapeJsonString(const std::string &str) const
+bool DiscordRichPresence::writeFrame(uint32_t opcode)
 {
-    std::string escaped;
-    escaped.reserve(str.size() + 10); // Reserve extra space for escape characters
+    // Header and payload go out in a single write, the buffer keeps its
+    // capacity between frames
+    const DiscordIPCHeader header { 
+        opcode, static_cast<uint32_t>(m_frame.size() - sizeof(DiscordIPCHeader)) 
+    };
+    std::memcpy(m_frame.data(), &header, sizeof(header));
 
-    for (unsigned char c : str)
     {
-        switch (c)
-        {
-        case '"':
-            escaped += "\\\"";
-            break;
-        case '\\':
-            escaped += "\\\\";
-            break;
-        case '\b':
-            escaped += "\\b";
-            break;
-        case '\f':
-            escaped += "\\f";
-            break;
-        case '\n':
-            escaped += "\\n";
-            break;
-        case '\r':
-            escaped += "\\r";
-            break;
-        case '\t':
-            escaped += "\\t";
-            break;
-        default:
-            if (c < 32)
-            {
-                char buf[7];
-                snprintf(buf, sizeof(buf), "\\u%04x", c);
-                escaped += buf;
-            }
-            else
-            {
-                escaped += (char)c;
-            }
-            break;
-        }
+        ScopedTimer timer(STAGE_FRAME_WRITE);
+        if (!m_transport->Write(m_frame.data(), m_frame.size(), WRITE_TIMEOUT_MS))
+            return false;
     }
-    return escaped;
+
+    m_counters.framesSent.fetch_add(1, std::memory_order_relaxed);
+    m_counters.bytesSent.fetch_add(m_frame.size(), std::memory_order_relaxed);
+
+    // Any frame shows that the connection works, the heartbeat is only
+    // needed after a quiet interval
+    const int64_t heartbeat = m_heartbeatSeconds.load(std::memory_order_relaxed);
+    if (heartbeat > 0)
+        m_timers.Schedule(TIMER_HEARTBEAT, Clock::now() + std::chrono::seconds(heartbeat));
+    else
+        m_timers.Cancel(TIMER_HEARTBEAT);
+    return true;
 }
 
-bool DiscordRichPresence::connectToDiscord(__int64 clientId, ErrorCallback exc)
+bool DiscordRichPresence::ReadFrame(uint32_t &opcode, uint32_t timeoutMs)
 {
-    if (m_pipe != INVALID_HANDLE_VALUE)
+    DiscordIPCHeader header{};
+    if (!m_transport->Read(&header, sizeof(header), timeoutMs))
     {
-        ::CloseHandle(m_pipe);
-        m_pipe = INVALID_HANDLE_VALUE;
+        Report("Failed to read response header from pipe");
+        return false;
+    }
+    if (header.length > MAX_FRAME_LENGTH)
+    {
+        Report("Invalid response length from pipe: " + std::to_string(header.length));
+        return false;
     }
 
-    for (int i = 0; i < MAX_PIPE_ATTEMPTS; i++)
+    // The body keeps its capacity between frames
+    m_readBody.resize(header.length);
+    if (header.length > 0 && !m_transport->Read(m_readBody.data(), header.length, timeoutMs))
     {
-        std::string pipeName = R"(\\.\pipe\discord-ipc-)" + std::to_string(i);
-        if (WaitNamedPipeA(pipeName.c_str(), 100))
-        {
-            m_pipe = ::CreateFileA(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
-                                   FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, NULL);
-            if (m_pipe != INVALID_HANDLE_VALUE)
-            {
-                std::string handshake = R"({"v":1,"client_id":")" + std::to_string(clientId) + R"("})";
-                if (sendDiscordMessageSync(0, handshake, exc))
-                    return true;
-                ::CloseHandle(m_pipe);
-                m_pipe = INVALID_HANDLE_VALUE;
-            }
-        }
+        Report("Failed to read response body from pipe");
+        return false;
     }
-    if (exc)
-        exc("Could not connect to Discord. Is Discord running?");
-    return false;
+
+    opcode = header.opcode;
+    m_counters.framesReceived.fetch_add(1, std::memory_order_relaxed);
+    m_counters.bytesReceived.fetch_add(sizeof(header) + header.length, std::memory_order_relaxed);
+    return true;
 }
 
-namespace
+bool DiscordRichPresence::HandleFrame(uint32_t opcode, const std::string &body)
 {
-    static constexpr DWORD PIPE_WRITE_TIMEOUT_MS = 2000; // 2s per write op
-    static constexpr DWORD PIPE_READ_TIMEOUT_MS = 3000;  // 3s per read op
-
-    struct HandleDeleter
+    switch (opcode)
     {
-        void operator()(HANDLE h) const
+    case OP_CLOSE:
+        Report("Discord closed the connection: " + body);
+        return false;
+    case OP_PING:
+        // Discord checks the connection, the PONG echoes the payload
+        m_counters.pingsAnswered.fetch_add(1, std::memory_order_relaxed);
+        if (!sendFrame(OP_PONG, body))
         {
-            if (h != NULL && h != INVALID_HANDLE_VALUE)
-                ::CloseHandle(h);
+            Report("Failed to answer the heartbeat of Discord");
+            return false;
         }
-    };
-
-    using UniqueHandle = std::unique_ptr<void, HandleDeleter>;
+        return true;
+    case OP_PONG:
+        m_counters.pongsReceived.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    case OP_FRAME:
+        break;
+    default:
+        return true;
+    }
 
-    bool writeWithTimeout(HANDLE pipe, const void *buffer, DWORD size, DWORD timeoutMs)
+    // Successful answers echo the whole activity, only the nonce and the
+    // event are read from them
+    DiscordResponse response;
+    if (!ScanResponse(body, response))
     {
-        if (pipe == INVALID_HANDLE_VALUE)
-            return false;
-
-        OVERLAPPED ov{};
-        ov.hEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
-        if (!ov.hEvent)
-            return false;
+        Report("Failed to parse Discord response: not a JSON object");
+        return true;
+    }
 
-        UniqueHandle ovHandle(ov.hEvent);
+    // Frames without the nonce of a command are events, READY is the only
+    // one the client waits for
+    if (response.evt == "READY")
+        m_ready = true;
 
-        DWORD written = 0;
-        if (!WriteFile(pipe, buffer, size, &written, &ov))
-        {
-            DWORD err = ::GetLastError();
-            if (err != ERROR_IO_PENDING)
-            {
-                return false;
-            }
+    const bool answered = CompleteCommand(response.nonce);
+    if (response.evt == "ERROR")
+        ReportError(body);
+    else if (answered)
+        m_lastDiscordError.clear();
+    return true;
+}
 
-            DWORD waitRes = ::WaitForSingleObject(ov.hEvent, timeoutMs);
-            if (waitRes != WAIT_OBJECT_0)
-            {
-                ::CancelIo(pipe);
-                return false;
-            }
+bool DiscordRichPresence::CompleteCommand(std::string_view nonce)
+{
+    if (nonce.empty())
+        return false;
 
-            if (!::GetOverlappedResult(pipe, &ov, &written, FALSE) || written != size)
-            {
-                return false;
-            }
-        }
-        else if (written != size)
-        {
-            return false;
-        }
+    const auto command = std::find_if(m_inFlight.begin(), m_inFlight.end(),
+        [&](const InFlightCommand &c) { return c.nonce == nonce; });
+    if (command == m_inFlight.end())
+        return false;
 
-        return true;
-    }
+    if (Metrics::Enabled())
+        Metrics::Record(STAGE_ROUND_TRIP, Clock::now() - command->sentAt);
+    m_inFlight.erase(m_inFlight.begin(), command + 1);
+    if (m_inFlight.empty())
+        m_timers.Cancel(TIMER_RESPONSE);
+    else
+        m_timers.Schedule(TIMER_RESPONSE, m_inFlight.front().sentAt + RESPONSE_TIMEOUT);
+    return true;
+}
 
-    bool readWithTimeout(HANDLE pipe, void *buffer, DWORD size, DWORD timeoutMs, DWORD &bytesReadOut)
+bool DiscordRichPresence::ReadUntil(std::chrono::steady_clock::time_point deadline,
+    bool (DiscordRichPresence::*done)() const, bool whileStopping)
+{
+    while (!(this->*done)())
     {
-        bytesReadOut = 0;
-        if (pipe == INVALID_HANDLE_VALUE)
+        // The wake of Close may have been taken by this wait, the UI thread
+        // is blocked in join until the worker sees it
+        if (m_stopping && !whileStopping)
             return false;
 
-        OVERLAPPED ov{};
-        ov.hEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
-        if (!ov.hEvent)
+        const uint32_t remaining = remainingMilliseconds(deadline);
+        if (remaining == 0)
             return false;
 
-        UniqueHandle ovHandle(ov.hEvent);
+        uint32_t opcode = 0;
+        const IpcTransport::WaitResult result = m_transport->Wait(remaining);
+        if (result == IpcTransport::WaitResult::Woken)
+            continue; // A post, the worker takes it once this wait is over
+        if (result != IpcTransport::WaitResult::Readable ||
+            !ReadFrame(opcode, remainingMilliseconds(deadline)) || !HandleFrame(opcode, m_readBody))
+            return false;
+    }
+    return true;
+}
 
-        if (!ReadFile(pipe, buffer, size, &bytesReadOut, &ov))
-        {
-            DWORD err = ::GetLastError();
-            if (err != ERROR_IO_PENDING)
-            {
-                return false;
-            }
+void DiscordRichPresence::ReportError(const std::string &body)
+{
+    // Errors are rare, the DOM gives the code and the message as Discord
+    // sent them
+    std::string message;
+    try
+    {
+        nlohmann::json j = json::parse(body);
+        const json &data = j.contains("data") ? j["data"] : j;
+        std::string errorCode = data.contains("code") ? data["code"].dump() : "Unknown";
+        std::string errorMessage = data.contains("message") ? data["message"].dump() : "Discord Error";
+        message = "Discord Error " + errorCode + ": " + errorMessage;
+    }
+    catch (const json::exception &e)
+    {
+        Report("Failed to parse Discord response: " + std::string(e.what()));
+        return;
+    }
 
-            DWORD waitRes = ::WaitForSingleObject(ov.hEvent, timeoutMs);
-            if (waitRes != WAIT_OBJECT_0)
-            {
-                ::CancelIo(pipe);
-                return false;
-            }
+    // A rejected presence is not sent again, but the next one usually
+    // fails the same way
+    if (message == m_lastDiscordError)
+        return;
+    m_lastDiscordError = message;
 
-            if (!::GetOverlappedResult(pipe, &ov, &bytesReadOut, FALSE))
-            {
-                return false;
-            }
+    try
+    {
+        if (m_discordError)
+        {
+            m_counters.errors.fetch_add(1, std::memory_order_relaxed);
+            m_discordError(message);
         }
+        else
+            Report(message);
+    }
+    catch (...)
+    {
+    }
+}
 
-        return true;
+void DiscordRichPresence::Report(const std::string &message) const noexcept
+{
+    m_counters.errors.fetch_add(1, std::memory_order_relaxed);
+    try
+    {
+        if (m_exc)
+            m_exc(message);
+    }
+    catch (...)
+    {
     }
 }
 
-bool DiscordRichPresence::UpdatePresence(const Presence &presence, ErrorCallback exc) noexcept
+bool DiscordRichPresence::Start(int64_t clientId, ErrorCallback exc, ErrorCallback discordError) noexcept
 {
-    if (!m_connected || m_pipe == INVALID_HANDLE_VALUE)
+    if (m_worker.joinable())
+        return true;
+    if (!m_transport)
+        return false;
+
+    m_clientId = clientId;
+    m_exc = exc;
+    m_discordError = discordError;
+    m_lastDiscordError.clear();
+    m_stopping = false;
+    m_reconnectIntervalMs = RECONNECT_MIN_INTERVAL_MS;
+    m_absenceReported = false;
+    m_standby = false;
+
+    // Without shared memory the process keeps its own connection, as
+    // without arbitration
+    if (m_arbitrate)
+        m_arbiter.Open(clientId, Clock::time_point(Clock::duration(m_lastActivity.load())));
+
+    try
     {
-        if (exc)
-            exc("Not connected to Discord");
+        m_worker = std::thread(&DiscordRichPresence::Run, this);
+    }
+    catch (const std::exception &e)
+    {
+        Report(e.what());
         return false;
     }
-
-    m_lastJsonSent = presenceToJson(presence);
-    return sendDiscordMessageSync(1, m_lastJsonSent, exc);
+    return true;
 }
 
-bool DiscordRichPresence::sendDiscordMessageSync(uint32_t opcode, const std::string &json, ErrorCallback exc)
+void DiscordRichPresence::Close() noexcept
 {
-    DiscordIPCHeader header { 
-        opcode, static_cast<uint32_t>(json.size()) 
-    };
+    if (!m_worker.joinable())
+        return;
 
-    if (!writeWithTimeout(m_pipe, &header, sizeof(header), PIPE_WRITE_TIMEOUT_MS))
-        return false;
-    if (!writeWithTimeout(m_pipe, json.c_str(), static_cast<DWORD>(json.size()), PIPE_WRITE_TIMEOUT_MS))
-        return false;
+    // The worker clears the activity before it exits
+    m_stopping = true;
+    m_transport->Wake();
+    m_worker.join();
+}
 
-    DiscordIPCHeader responseHeader{};
-    DWORD bytesRead;
+void DiscordRichPresence::PostPresence(const Presence &presence, bool isIdling) noexcept
+{
+    if (!isIdling)
+    {
+        const auto now = Clock::now();
+        m_lastActivity.store(now.time_since_epoch().count());
+        m_arbiter.Touch(now);
+    }
 
-    if (!readWithTimeout(m_pipe, &responseHeader, sizeof(responseHeader), PIPE_READ_TIMEOUT_MS, bytesRead) ||
-        bytesRead != sizeof(responseHeader))
+    try
     {
-        if (exc)
-            exc("Failed to read response header from pipe");
-        disconnect();
-        return false;
+        m_activitySlot.Publish(presence);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return;
     }
+    if (m_transport)
+        m_transport->Wake();
+}
 
-    if (responseHeader.length > 0)
+void DiscordRichPresence::SetIdleStatus(const Presence *presence, std::chrono::seconds timeout) noexcept
+{
+    IdleRequest request;
+    try
     {
-        std::string response(responseHeader.length, '\0');
-        if (!readWithTimeout(m_pipe, response.data(), responseHeader.length, PIPE_READ_TIMEOUT_MS, bytesRead) ||
-            bytesRead != responseHeader.length)
+        if (presence && timeout.count() > 0)
         {
-            if (exc)
-                exc("Failed to read response body from pipe");
-            return false;
+            request.timeout = timeout;
+            request.presence = *presence;
         }
+        m_idleSlot.Publish(request);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return;
+    }
+    if (m_transport)
+        m_transport->Wake();
+}
+
+void DiscordRichPresence::SetHeartbeatInterval(std::chrono::seconds interval) noexcept
+{
+    // Applied when the next frame is sent
+    m_heartbeatSeconds.store(interval.count() > 0 ? interval.count() : 0);
+}
+
+DiscordIPCStats DiscordRichPresence::GetStats() const noexcept
+{
+    DiscordIPCStats stats;
+    stats.framesSent = m_counters.framesSent.load(std::memory_order_relaxed);
+    stats.bytesSent = m_counters.bytesSent.load(std::memory_order_relaxed);
+    stats.framesReceived = m_counters.framesReceived.load(std::memory_order_relaxed);
+    stats.bytesReceived = m_counters.bytesReceived.load(std::memory_order_relaxed);
+    stats.activitiesSent = m_counters.activitiesSent.load(std::memory_order_relaxed);
+    stats.activitiesSkipped = m_counters.activitiesSkipped.load(std::memory_order_relaxed);
+    stats.pingsSent = m_counters.pingsSent.load(std::memory_order_relaxed);
+    stats.pongsReceived = m_counters.pongsReceived.load(std::memory_order_relaxed);
+    stats.pingsAnswered = m_counters.pingsAnswered.load(std::memory_order_relaxed);
+    stats.connections = m_counters.connections.load(std::memory_order_relaxed);
+    stats.errors = m_counters.errors.load(std::memory_order_relaxed);
+    stats.handovers = m_counters.handovers.load(std::memory_order_relaxed);
+    return stats;
+}
 
-        try
+void DiscordRichPresence::Run() noexcept
+{
+    try
+    {
+        // Every wait of the worker ends at the earliest deadline or when a
+        // post or Close wakes the transport
+        m_timers.Clear();
+        if (m_arbiter.IsOpen())
+            m_timers.Schedule(TIMER_ARBITER, Clock::now());
+        m_timers.Schedule(TIMER_RECONNECT, Clock::now());
+        while (!m_stopping)
         {
-            nlohmann::json j = json::parse(response);
-            if (j.contains("evt") && j["evt"] == "ERROR")
+            auto now = Clock::now();
+            size_t timer;
+            while (!m_stopping && m_timers.PopExpired(now, timer))
             {
-                std::string errorCode = j.contains("code") ? j["code"].dump() : "Unknown";
-                std::string errorMessage = j.contains("message") ? j["message"].dump() : "Discord Error";
-                if (exc)
-                    exc("Discord Error " + errorCode + ": " + errorMessage);
-                return false;
+                OnTimer(timer, now);
+                now = Clock::now();
+            }
+            if (m_stopping)
+                break;
+
+            // After the timers: the handshake of a reconnection may have
+            // consumed the wake of a post
+            TakePending();
+            UpdateOwnership(now);
+            UpdateIdle(now);
+            if (m_connected && m_inFlight.size() < MAX_IN_FLIGHT)
+                SendIfNeeded(now);
+
+            uint32_t opcode = 0;
+            switch (m_transport->Wait(m_timers.TimeoutMs(Clock::now())))
+            {
+            case IpcTransport::WaitResult::Readable:
+                if (!ReadFrame(opcode, READ_TIMEOUT_MS) || !HandleFrame(opcode, m_readBody))
+                    connectionLost();
+                break;
+            case IpcTransport::WaitResult::Failed:
+                if (m_connected)
+                {
+                    Report("The connection with Discord was lost");
+                    connectionLost();
+                }
+                break;
+            default:
+                break;
             }
-            return true;
         }
-        catch (const json::parse_error &e)
+
+        if (m_connected)
+            SendClearActivity();
+    }
+    catch (const std::exception &e)
+    {
+        Report(e.what());
+    }
+    disconnect();
+    m_arbiter.Close();
+}
+
+void DiscordRichPresence::OnTimer(size_t timer, std::chrono::steady_clock::time_point now)
+{
+    switch (timer)
+    {
+    case TIMER_RECONNECT:
+        if (!m_connected && !m_standby && !connectToDiscord(m_clientId))
+            ScheduleReconnect(now);
+        break;
+    case TIMER_RESPONSE:
+        if (!m_inFlight.empty())
         {
-            if (exc)
-                exc("Failed to parse Discord response: " + std::string(e.what()));
-            return false;
+            Report("Discord did not answer in time");
+            connectionLost();
         }
+        break;
+    case TIMER_HEARTBEAT:
+        if (m_connected)
+            SendPing();
+        break;
+    case TIMER_ARBITER:
+        m_arbiter.Refresh(now);
+        UpdateOwnership(now);
+        m_timers.Schedule(TIMER_ARBITER, now + InstanceArbiter::REFRESH_INTERVAL);
+        break;
+    default:
+        // The idle deadline only wakes the worker, the state is evaluated
+        // after the timers
+        break;
     }
-
-    return true;
 }
 
-void DiscordRichPresence::Update(ErrorCallback exc) noexcept
+void DiscordRichPresence::UpdateIdle(std::chrono::steady_clock::time_point now)
 {
-    AutoUnlock lock(m_mutex);
-    if (!m_connected || m_pipe == INVALID_HANDLE_VALUE || m_lastJsonSent.empty())
-        return;
-
-    if (!sendDiscordMessageSync(1, m_lastJsonSent, exc))
+    if (m_idle.timeout.count() <= 0)
     {
-        m_connected = false;
+        m_isIdle = false;
+        m_timers.Cancel(TIMER_IDLE);
         return;
     }
+
+    const Clock::time_point deadline =
+        Clock::time_point(Clock::duration(m_lastActivity.load())) + m_idle.timeout;
+    m_isIdle = now >= deadline;
+    if (m_isIdle)
+        m_timers.Cancel(TIMER_IDLE);
+    else
+        m_timers.Schedule(TIMER_IDLE, deadline);
 }
 
-bool DiscordRichPresence::Connect(__int64 clientId, ErrorCallback exc) noexcept
+void DiscordRichPresence::UpdateOwnership(std::chrono::steady_clock::time_point now)
 {
-    AutoUnlock lock(m_mutex);
-    if (!m_connected)
-        return m_connected = connectToDiscord(clientId, exc);
-    return true;
+    if (!m_arbiter.IsOpen())
+        return;
+
+    const bool standby = !m_arbiter.IsOwner(now);
+    if (standby == m_standby)
+        return;
+    m_standby = standby;
+    m_counters.handovers.fetch_add(1, std::memory_order_relaxed);
+
+    if (standby)
+    {
+        // The activity is not cleared: the new owner already sent its own,
+        // and Discord drops the one of a closed connection, so the profile
+        // never shows an empty presence in between
+        disconnect();
+        m_timers.Cancel(TIMER_RECONNECT);
+    }
+    else
+    {
+        // The user came back to this editor, the presence is sent as soon
+        // as the handshake completes
+        m_reconnectIntervalMs = RECONNECT_MIN_INTERVAL_MS;
+        m_timers.Schedule(TIMER_RECONNECT, now);
+    }
 }
 
-void DiscordRichPresence::Close(ErrorCallback exc) noexcept
+void DiscordRichPresence::TakePending()
 {
-    AutoUnlock lock(m_mutex);
-    if (m_connected && m_pipe != INVALID_HANDLE_VALUE)
+    // The nodes are copied and handed back, so they keep their capacity for
+    // the next publish
+    if (Presence *activity = m_activitySlot.Take())
     {
-        std::string clearActivity = R"({"cmd":"SET_ACTIVITY","args":{"pid":)" + std::to_string(::GetCurrentProcessId())
-            + R"(,"activity":null},"nonce":")" + generateNonce() + R"("})";
-        sendDiscordMessageSync(1, clearActivity, exc);
-        disconnect();
+        m_activity = *activity;
+        m_hasActivity = true;
+        m_activityChanged = true;
+        m_activitySlot.Recycle(activity);
+    }
+    if (IdleRequest *idle = m_idleSlot.Take())
+    {
+        m_idle = *idle;
+        m_idleSlot.Recycle(idle);
     }
 }
 
-bool DiscordRichPresence::SetPresence(const Presence &presence, bool isIdling, ErrorCallback exc) noexcept
+void DiscordRichPresence::SendIfNeeded(std::chrono::steady_clock::time_point now)
 {
-    AutoUnlock lock(m_mutex);
+    if (!m_isIdle && !m_hasActivity)
+        return;
 
-    if (!isIdling)
+    const Presence &desired = m_isIdle ? m_idle.presence : m_activity;
+    const int64_t startTime = desired.startTime > 0 ? desired.startTime : m_sessionStart.load();
+
+    // The fields with the revision of the last presence sent are not
+    // compared again
+    const bool changed = m_activityChanged;
+    m_activityChanged = false;
+    if (m_hasSent && m_sent.startTime == startTime && m_sent.endTime == desired.endTime &&
+        m_sent.enableButtonRepository == desired.enableButtonRepository && m_sent.SameTexts(desired))
     {
-        m_lastUpdateTime.store(std::chrono::duration_cast<std::chrono::seconds>(
-                                   std::chrono::system_clock::now().time_since_epoch())
-                                   .count());
+        // No changes, Discord still shows it
+        if (changed)
+            m_counters.activitiesSkipped.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
 
-    if (m_presence.compare(presence))
-        return true; // No changes, skip update
-    m_presence = presence;
+    // The assignment reuses the capacity of the strings of m_sent
+    m_sent = desired;
+    m_sent.startTime = startTime;
+    m_hasSent = true;
+
+    // The command is streamed into the frame, the nonce fits in the
+    // small string buffer so nothing is allocated
+    std::string nonce = generateNonce();
+    beginFrame();
+    {
+        ScopedTimer timer(STAGE_SERIALIZE);
+        m_serializer.Serialize(m_frame, m_sent, nonce, currentProcessId());
+    }
+    if (!writeFrame(OP_FRAME))
+    {
+        Report("Failed to write the presence to the pipe");
+        connectionLost();
+        return;
+    }
 
-    return UpdatePresence(presence, exc);
+    // The deadline is the one of the oldest command
+    m_inFlight.push_back({ std::move(nonce), now });
+    if (m_inFlight.size() == 1)
+        m_timers.Schedule(TIMER_RESPONSE, now + RESPONSE_TIMEOUT);
+    m_counters.activitiesSent.fetch_add(1, std::memory_order_relaxed);
 }
 
-bool DiscordRichPresence::SetIdleStatus(const Presence *presence, ErrorCallback exc) noexcept
+void DiscordRichPresence::SendPing()
 {
-    AutoUnlock lock(m_mutex);
-
-    if (!m_connected || m_pipe == INVALID_HANDLE_VALUE)
+    // Answered with a PONG, a broken connection fails the write or ends
+    // the pending read
+    beginFrame();
+    m_frame += R"({"nonce":")";
+    m_frame += generateNonce();
+    m_frame += R"("})";
+    if (!writeFrame(OP_PING))
     {
-        if (exc)
-            exc("Not connected to Discord");
-        return false;
+        Report("Failed to write the heartbeat to the pipe");
+        connectionLost();
+        return;
     }
+    m_counters.pingsSent.fetch_add(1, std::memory_order_relaxed);
+}
 
-    // If no presence is provided, use the last known presence
-    m_lastJsonSent = presenceToJson(!presence ? m_presence : *presence);
-    return sendDiscordMessageSync(1, m_lastJsonSent, exc);
+void DiscordRichPresence::SendClearActivity()
+{
+    std::string nonce = generateNonce();
+    std::string clearActivity = R"({"cmd":"SET_ACTIVITY","args":{"pid":)" + std::to_string(currentProcessId())
+        + R"(,"activity":null},"nonce":")" + nonce + R"("})";
+    if (!sendFrame(OP_FRAME, clearActivity))
+        return;
+
+    // Gives Discord a moment to process it before the connection is closed
+    m_inFlight.push_back({ std::move(nonce), Clock::now() });
+    ReadUntil(Clock::now() + CLEAR_TIMEOUT, &DiscordRichPresence::NothingInFlight, true);
 }
 
-void DiscordRichPresence::disconnect()
+void DiscordRichPresence::disconnect() noexcept
 {
-    if (m_pipe != INVALID_HANDLE_VALUE)
+    if (m_transport)
+        m_transport->Disconnect();
+    m_inFlight.clear();
+    m_ready = false;
+    m_hasSent = false;
+    m_connected = false;
+    m_timers.Cancel(TIMER_RESPONSE);
+    m_timers.Cancel(TIMER_HEARTBEAT);
+}
+
+void DiscordRichPresence::connectionLost()
+{
+    const auto now = Clock::now();
+    const bool stable = m_connected && now - m_connectedSince >= STABLE_CONNECTION;
+    disconnect();
+
+    // After a stable connection the first attempt is immediate and the
+    // backoff starts again if it fails
+    if (stable)
     {
-        ::CloseHandle(m_pipe);
-        m_pipe = INVALID_HANDLE_VALUE;
+        m_reconnectIntervalMs = RECONNECT_MIN_INTERVAL_MS;
+        m_timers.Schedule(TIMER_RECONNECT, now);
     }
-    m_connected = false;
-}
\ No newline at end of file
+    else
+    {
+        ScheduleReconnect(now);
+    }
+}
+
+void DiscordRichPresence::ScheduleReconnect(std::chrono::steady_clock::time_point now)
+{
+    m_timers.Schedule(TIMER_RECONNECT, now + std::chrono::milliseconds(m_reconnectIntervalMs));
+    m_reconnectIntervalMs = std::min(m_reconnectIntervalMs * 2, RECONNECT_MAX_INTERVAL_MS);
+}
@@ -1,4 +1,4 @@
-// Copyright (C) 2025 Zukaritasu
+// Copyright (C) 2025 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -15,45 +15,41 @@
 
 #pragma once
 
-#include <windows.h>
 #include <string>
 #include <chrono>
 #include <cstdint>
 #include <string_view>
 #include <functional>
 #include <atomic>
-#include <cstdint>
 #include <memory>
-#include "PluginThread.h"
+#include <thread>
+#include <vector>
+#include "InstanceArbiter.hpp"
+#include "IpcTransport.hpp"
+#include "LatestSlot.hpp"
+#include "Presence.hpp"
+#include "PresenceSerializer.hpp"
+#include "TimerQueue.hpp"
 
 typedef std::function<void(const std::string &)> ErrorCallback;
 
-struct Presence
+/**
+ * Traffic counters of a DiscordRichPresence since it was constructed
+ */
+struct DiscordIPCStats
 {
-    std::string state;
-    std::string details;
-    std::string largeImage;
-    std::string largeText;
-    std::string smallImage;
-    std::string smallText;
-    std::string repositoryUrl;
-    int64_t startTime = 0;
-    int64_t endTime = 0;
-    bool enableButtonRepository = false;
-
-    bool compare(const Presence &other) const
-    {
-        return state == other.state &&
-               details == other.details &&
-               largeImage == other.largeImage &&
-               largeText == other.largeText &&
-               smallImage == other.smallImage &&
-               smallText == other.smallText &&
-               repositoryUrl == other.repositoryUrl &&
-               startTime == other.startTime &&
-               endTime == other.endTime &&
-               enableButtonRepository == other.enableButtonRepository;
-    }
+    uint64_t framesSent = 0;
+    uint64_t bytesSent = 0;         // Headers included
+    uint64_t framesReceived = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t activitiesSent = 0;    // SET_ACTIVITY frames
+    uint64_t activitiesSkipped = 0; // Posts equal to the presence shown
+    uint64_t pingsSent = 0;
+    uint64_t pongsReceived = 0;
+    uint64_t pingsAnswered = 0;     // PINGs of Discord answered with a PONG
+    uint64_t connections = 0;
+    uint64_t errors = 0;            // Reported through the error callbacks
+    uint64_t handovers = 0;         // Connection given to or taken from another process
 };
 
 struct DiscordIPCHeader
@@ -62,30 +58,172 @@ struct DiscordIPCHeader
     uint32_t length;
 };
 
+/**
+ * Discord IPC client. A worker thread owns the transport: it connects and
+ * reconnects, sends the latest presence and reads the responses of Discord.
+ * Other threads only publish presence snapshots, which never blocks them on
+ * the connection. The framing, the handshake and the messages are
+ * independent of the transport, see IpcTransport.
+ */
 class DiscordRichPresence
 {
 private:
-    static constexpr int MAX_PIPE_ATTEMPTS = 10;
-    static constexpr int PING_INTERVAL = 1800;
-    static constexpr int MIN_STRING_LENGTH = 2;
+    // Enough for a presence with every field, larger frames grow the buffer
+    static constexpr size_t FRAME_BUFFER_SIZE = 2048;
+    // Discord frames are small, a larger length means a corrupt stream
+    static constexpr uint32_t MAX_FRAME_LENGTH = 1024 * 1024;
+    // While Discord is absent the probes back off from the minimum to the
+    // maximum interval, a lost connection is retried at once
+    static constexpr uint32_t RECONNECT_MIN_INTERVAL_MS = 250;
+    static constexpr uint32_t RECONNECT_MAX_INTERVAL_MS = 8000;
+    // A connection lost after this time is retried at once, a shorter one
+    // continues the backoff so a flapping endpoint is not hammered
+    static constexpr std::chrono::seconds STABLE_CONNECTION{ 5 };
+    static constexpr uint32_t WRITE_TIMEOUT_MS = 2000;
+    static constexpr uint32_t READ_TIMEOUT_MS = 3000;
+    // A PING is sent after this time without any frame, 0 disables it
+    static constexpr std::chrono::seconds DEFAULT_HEARTBEAT_INTERVAL{ 15 };
+    // Time Discord has to answer a SET_ACTIVITY before the connection is
+    // considered lost
+    static constexpr std::chrono::milliseconds RESPONSE_TIMEOUT{ 3000 };
+    // Close waits this long for the answer of the activity cleared on exit,
+    // the UI thread is joining the worker
+    static constexpr std::chrono::milliseconds CLEAR_TIMEOUT{ 500 };
+    // SET_ACTIVITY commands sent before the answer of the first one, so a
+    // new presence does not wait for the round trip of the previous one
+    static constexpr size_t MAX_IN_FLIGHT = 2;
 
-    BasicMutex m_mutex;
-    HANDLE m_pipe = INVALID_HANDLE_VALUE;
-    bool m_connected;
-    std::atomic<__int64> m_lastUpdateTime;
-    struct Presence m_presence;
+    enum Opcode : uint32_t
+    {
+        OP_HANDSHAKE = 0,
+        OP_FRAME     = 1,
+        OP_CLOSE     = 2,
+        OP_PING      = 3,
+        OP_PONG      = 4
+    };
+
+    // Deadlines of the worker, it sleeps until the earliest one
+    enum Timer : size_t
+    {
+        TIMER_RECONNECT, // Next connection attempt
+        TIMER_RESPONSE,  // Discord has to answer the SET_ACTIVITY in flight
+        TIMER_HEARTBEAT, // A PING checks that Discord is still there
+        TIMER_IDLE,      // Last activity + idle timeout
+        TIMER_ARBITER,   // The entry of the process in the shared table is refreshed
+        TIMER_COUNT
+    };
+
+    struct InFlightCommand
+    {
+        std::string nonce;
+        std::chrono::steady_clock::time_point sentAt;
+    };
+
+    struct IdleRequest
+    {
+        std::chrono::seconds timeout{ 0 }; // 0: the idle status is disabled
+        Presence presence;
+    };
 
-    // It is initialized with the SetIdleStatus and SetPresence functions.
-    std::string m_lastJsonSent;
+    // Written by any thread, taken by the worker. A snapshot that is
+    // replaced before the worker takes it is never sent
+    LatestSlot<Presence> m_activitySlot;
+    LatestSlot<IdleRequest> m_idleSlot;
 
-    bool UpdatePresence(const Presence &presence, ErrorCallback exc) noexcept;
-    bool sendDiscordMessageSync(uint32_t opcode, const std::string &json, ErrorCallback exc);
-    bool connectToDiscord(__int64 clientId, ErrorCallback exc);
-    void disconnect();
+    std::unique_ptr<IpcTransport> m_transport;
+    std::thread m_worker;
+    std::atomic<bool> m_stopping;
+    int64_t m_clientId = 0;
+    ErrorCallback m_exc;
+    ErrorCallback m_discordError;
 
-    std::string presenceToJson(const Presence &presence);
-    std::string generateNonce() const;
-    std::string escapeJsonString(const std::string &str) const;
+    std::atomic<bool> m_connected;
+    // Another editor process was active later and holds the connection
+    std::atomic<bool> m_standby;
+    bool m_arbitrate = false;
+    InstanceArbiter m_arbiter;
+    std::atomic<int64_t> m_heartbeatSeconds;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> framesSent{ 0 }, bytesSent{ 0 };
+        std::atomic<uint64_t> framesReceived{ 0 }, bytesReceived{ 0 };
+        std::atomic<uint64_t> activitiesSent{ 0 }, activitiesSkipped{ 0 };
+        std::atomic<uint64_t> pingsSent{ 0 }, pongsReceived{ 0 }, pingsAnswered{ 0 };
+        std::atomic<uint64_t> connections{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<uint64_t> handovers{ 0 };
+    };
+    // Report is const, it still counts the errors
+    mutable Counters m_counters;
+
+    // steady_clock time of the last activity of the user, in nanoseconds
+    std::atomic<int64_t> m_lastActivity;
+    std::atomic<int64_t> m_sessionStart;
+
+    // Only used by the worker thread
+    // Endpoint of the last successful connection, tried first
+    int m_lastEndpoint = -1;
+    uint32_t m_reconnectIntervalMs = RECONNECT_MIN_INTERVAL_MS;
+    std::chrono::steady_clock::time_point m_connectedSince{};
+    // The absence of Discord is reported once, not on every probe
+    bool m_absenceReported = false;
+    // Header and payload of the frame being written
+    std::string m_frame;
+    // Payload of the last frame read
+    std::string m_readBody;
+    Presence m_activity;
+    bool m_hasActivity = false;
+    IdleRequest m_idle;
+    bool m_isIdle = false;
+    TimerQueue m_timers{ TIMER_COUNT };
+    // Last presence sent, with the start time stamped
+    Presence m_sent;
+    PresenceSerializer m_serializer;
+    bool m_hasSent = false;
+    // Commands waiting for their answer, oldest first. Discord answers in
+    // order, an answer also completes the commands sent before it
+    std::vector<InFlightCommand> m_inFlight;
+    // The READY event of the handshake was received
+    bool m_ready = false;
+    // The same error of Discord is reported once until a command succeeds
+    std::string m_lastDiscordError;
+    // A new activity was taken and not compared with m_sent yet
+    bool m_activityChanged = false;
+    uint64_t m_nonceCounter = 0;
+
+    void Run() noexcept;
+    void TakePending();
+    void OnTimer(size_t timer, std::chrono::steady_clock::time_point now);
+    void UpdateIdle(std::chrono::steady_clock::time_point now);
+    void UpdateOwnership(std::chrono::steady_clock::time_point now);
+    void SendIfNeeded(std::chrono::steady_clock::time_point now);
+    void SendPing();
+    bool ReadFrame(uint32_t &opcode, uint32_t timeoutMs);
+    bool HandleFrame(uint32_t opcode, const std::string &body);
+    // Stops early when Close is called, unless it is the final clear of
+    // the activity
+    bool ReadUntil(std::chrono::steady_clock::time_point deadline, bool (DiscordRichPresence::*done)() const,
+        bool whileStopping = false);
+    bool IsReady() const noexcept { return m_ready; }
+    bool NothingInFlight() const noexcept { return m_inFlight.empty(); }
+    bool CompleteCommand(std::string_view nonce);
+    void ReportError(const std::string &body);
+    void SendClearActivity();
+    void Report(const std::string &message) const noexcept;
+
+    bool sendFrame(uint32_t opcode, std::string_view json);
+    // A frame can also be built in place: beginFrame reserves the header,
+    // the payload is appended to m_frame and writeFrame sends it
+    void beginFrame();
+    bool writeFrame(uint32_t opcode);
+    bool connectToDiscord(int64_t clientId);
+    bool connectToEndpoint(int index, int64_t clientId);
+    void disconnect() noexcept;
+    void connectionLost();
+    void ScheduleReconnect(std::chrono::steady_clock::time_point now);
+
+    std::string generateNonce();
 
 public:
     /**
@@ -94,6 +232,12 @@ public:
      */
     DiscordRichPresence() noexcept;
 
+    /**
+     * @brief Constructs a client that talks to Discord through the given
+     * transport instead of the default one of the platform
+     */
+    explicit DiscordRichPresence(std::unique_ptr<IpcTransport> transport) noexcept;
+
     /**
      * @brief Destructor for DiscordRichPresence
      * @details Closes the connection and releases resources
@@ -105,57 +249,70 @@ public:
     DiscordRichPresence &operator=(const DiscordRichPresence &) = delete;
 
     /**
-     * @brief Updates the presence in Discord
-     * @param exc ErrorCallback callback function (optional)
-     * @details Sends the currently configured presence to Discord
+     * @brief Starts the worker that connects to Discord and keeps the
+     * presence updated
+     * @param clientId Discord application ID
+     * @param exc ErrorCallback called from the worker thread (optional)
+     * @param discordError ErrorCallback called from the worker thread with
+     * the errors Discord answers a command with. Without it they go to exc
+     * @return false if the worker could not be started
      */
-    void Update(ErrorCallback exc = nullptr) noexcept;
+    bool Start(int64_t clientId, ErrorCallback exc = nullptr, ErrorCallback discordError = nullptr) noexcept;
 
     /**
-     * @brief Connects to Discord using the client ID
-     * @param clientId Discord application ID
-     * @param exc ErrorCallback callback function (optional)
-     * @return true if connection was successful, false otherwise
+     * @brief Clears the presence, closes the connection with Discord and
+     * stops the worker
      */
-    bool Connect(__int64 clientId, ErrorCallback exc = nullptr) noexcept;
+    void Close() noexcept;
 
     /**
-     * @brief Closes the connection with Discord
-     * @param exc ErrorCallback callback function (optional)
-     * @details Disconnects and cleans up the IPC connection with Discord
+     * @brief Publishes the presence information
+     * @param presence Structure containing the presence data to display.
+     * If its startTime is 0, the time of the first connection is used
+     * @param isIdling If the argument is false, the user is active and the
+     * idle timeout starts again
+     * @details The presence is sent by the worker when it is connected. A
+     * presence published before the previous one was sent replaces it
      */
-    void Close(ErrorCallback exc = nullptr) noexcept;
+    void PostPresence(const Presence &presence, bool isIdling) noexcept;
 
     /**
-     * @brief Sets the presence information
+     * @brief Configures the idling status in Rich Presence
+     * 
      * @param presence Structure containing the presence data to display
-     * @param isIdling If the argument is false, the m_lastUpdateTime field is reset
-     * @param exc ErrorCallback callback function (optional)
-     * @return true if set successfully, false otherwise
+     * once the user is inactive for the timeout. If the argument is null,
+     * disable the idling state
+     * @param timeout Seconds without activity before the idling status
      */
-    bool SetPresence(const Presence &presence, bool isIdling, ErrorCallback exc = nullptr) noexcept;
+    void SetIdleStatus(const Presence *presence, std::chrono::seconds timeout) noexcept;
 
     /**
-     * @brief Enable idling status in Rich Presence
-     * 
-     * @param presence Structure containing the presence data to display. 
-     * If the argument is null, disable the idling state
-     * @param exc ErrorCallback callback function (optional)
-     * @return false if the pipe connection is not working
+     * @brief Sets how long the connection may stay without frames before
+     * a PING checks it, 0 disables the PING. An unchanged presence is never
+     * sent again, a closed connection is detected by the pending read
+     */
+    void SetHeartbeatInterval(std::chrono::seconds interval) noexcept;
+
+    /**
+     * @brief Shares the connection with the other processes that use the
+     * same application ID: only the one with the latest user activity
+     * stays connected, see InstanceArbiter. Applied by the next Start
      */
-    bool SetIdleStatus(const Presence *presence, ErrorCallback exc = nullptr) noexcept;
+    void SetArbitration(bool enabled) noexcept { m_arbitrate = enabled; }
+
+    /**
+     * @brief Whether another process holds the connection, thread safe
+     */
+    bool IsStandby() const noexcept { return m_standby.load(); }
+
+    /**
+     * @brief Snapshot of the traffic counters, thread safe
+     */
+    DiscordIPCStats GetStats() const noexcept;
 
     /**
      * @brief Checks if connected to Discord
      * @return true if connected, false otherwise
      */
-    bool IsConnected() const noexcept { return m_connected; }
-
-    bool LastUpdateTimeElapsed(int64_t elapsed) const noexcept
-    {
-        return (std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch())
-                    .count() -
-                m_lastUpdateTime.load()) >= elapsed;
-    }
+    bool IsConnected() const noexcept { return m_connected.load(); }
 };
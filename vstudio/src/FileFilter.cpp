@@ -1,4 +1,4 @@
-// Copyright (C) 2025 Zukaritasu
+// Copyright (C) 2025 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -15,84 +15,303 @@
 
 #include "FileFilter.hpp"
 
+#include <cstdlib>
 #include <filesystem>
-#include <regex>
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+// Git for Windows sets core.ignorecase, the file system is case insensitive
+static constexpr bool IGNORE_CASE = true;
+#else
+static constexpr bool IGNORE_CASE = false;
+#endif
+
+static void NormalizePath(std::string& path)
+{
+    for (char& c : path)
+    {
+        if (c == '\\')
+            c = '/';
+        else if (IGNORE_CASE && c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    }
+    while (path.size() > 1 && path.back() == '/')
+        path.pop_back();
+}
+
+static bool IsInside(std::string_view path, std::string_view directory) noexcept
+{
+    return path.size() > directory.size() &&
+           path.compare(0, directory.size(), directory) == 0 &&
+           path[directory.size()] == '/';
+}
+
+FileFilter::Level::Level() : matcher(IGNORE_CASE)
+{
+}
 
 bool FileFilter::IsPrivate(const std::string& filePath) const
 {
+    if (stack.empty())
+        return false;
+
     std::string normalizedPath = filePath;
-    std::replace(normalizedPath.begin(), normalizedPath.end(), '\\', '/');
+    NormalizePath(normalizedPath);
+
+    if (!IsInside(normalizedPath, stackRoot))
+    {
+        // Not below the workspace, only the name can be compared
+        size_t slash = normalizedPath.find_last_of('/');
+        std::string_view name = std::string_view(normalizedPath).substr(slash == std::string::npos ? 0 : slash + 1);
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+        {
+            GitignoreMatcher::Result result = it->level->matcher.Match(name, false);
+            if (result != GitignoreMatcher::Result::None)
+                return result == GitignoreMatcher::Result::Ignored;
+        }
+        return false;
+    }
 
-    for (const auto& pattern : ignorePatterns)
-        if (MatchesPattern(pattern, normalizedPath))
+    // git does not descend into an ignored directory, so a file inside one
+    // is ignored whatever the deeper levels say
+    const std::string_view path = normalizedPath;
+    for (size_t pos = path.find('/', stackRoot.size() + 1); pos != std::string_view::npos;
+         pos = path.find('/', pos + 1))
+    {
+        if (Decide(path.substr(0, pos), true) == GitignoreMatcher::Result::Ignored)
             return true;
-    return false;
+    }
+    return Decide(path, false) == GitignoreMatcher::Result::Ignored;
 }
 
-void FileFilter::LoadGitignore(const std::string& gitignorePath)
+GitignoreMatcher::Result FileFilter::Decide(std::string_view path, bool isDirectory) const noexcept
 {
-    if (gitignorePath.empty() || !std::filesystem::exists(gitignorePath))
+    // The deepest level that has an opinion about the path decides
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it)
     {
-		Clean();
+        if (!IsInside(path, it->base))
+            continue;
+
+        GitignoreMatcher::Result result =
+            it->level->matcher.Match(path.substr(it->base.size() + 1), isDirectory);
+        if (result != GitignoreMatcher::Result::None)
+            return result;
+    }
+    return GitignoreMatcher::Result::None;
+}
+
+void FileFilter::SelectDirectory(const std::string& directory, const std::string& root, bool isRepository)
+{
+    stack.clear();
+    stackRoot.clear();
+    if (root.empty())
         return;
+
+    stackRoot = root;
+    NormalizePath(stackRoot);
+
+    if (isRepository)
+    {
+        if (!globalExcludesResolved)
+        {
+            globalExcludes = FindGlobalExcludes();
+            globalExcludesResolved = true;
+        }
+        if (!globalExcludes.empty())
+            Push(globalExcludes, stackRoot);
+        Push((fs::path(root) / ".git" / "info" / "exclude").string(), stackRoot);
     }
 
-    ignorePatterns.clear();
-    std::ifstream file(gitignorePath);
-    if (!file.is_open())
+    Push((fs::path(root) / ".gitignore").string(), stackRoot);
+
+    std::string normalizedDirectory = directory;
+    NormalizePath(normalizedDirectory);
+    if (!IsInside(normalizedDirectory, stackRoot))
+        return;
+
+    // One level for every directory between the root and the file
+    fs::path current = root;
+    std::string_view rest = std::string_view(normalizedDirectory).substr(stackRoot.size() + 1);
+    while (!rest.empty())
     {
-		Clean();
+        size_t slash = rest.find('/');
+        std::string_view component = rest.substr(0, slash);
+        current /= fs::path(std::string(component));
+
+        const size_t baseLength = normalizedDirectory.size() - rest.size() + component.size();
+        Push((current / ".gitignore").string(), normalizedDirectory.substr(0, baseLength));
+
+        if (slash == std::string_view::npos)
+            break;
+        rest.remove_prefix(slash + 1);
+    }
+}
+
+void FileFilter::LoadGitignore(const std::string& gitignorePath)
+{
+    stack.clear();
+    stackRoot.clear();
+    if (gitignorePath.empty())
         return;
+
+    stackRoot = fs::path(gitignorePath).parent_path().string();
+    NormalizePath(stackRoot);
+    Push(gitignorePath, stackRoot);
+}
+
+void FileFilter::Push(const std::string& path, const std::string& base)
+{
+    std::shared_ptr<Level> level = Acquire(path);
+    if (!level->matcher.Empty())
+        stack.push_back({ std::move(level), base });
+}
+
+std::shared_ptr<FileFilter::Level> FileFilter::Acquire(const std::string& path)
+{
+    std::error_code ec;
+    Fingerprint fingerprint;
+    fingerprint.size = fs::file_size(path, ec);
+    fingerprint.exists = !ec;
+    if (fingerprint.exists)
+        fingerprint.time = fs::last_write_time(path, ec);
+
+    auto found = levelIndex.find(path);
+    if (found != levelIndex.end())
+    {
+        levels.splice(levels.begin(), levels, found->second);
+
+        const Fingerprint& cached = levels.front()->fingerprint;
+        if (cached.exists == fingerprint.exists && (!fingerprint.exists ||
+            (cached.size == fingerprint.size && cached.time == fingerprint.time)))
+        {
+            stats.hits++;
+            return levels.front();
+        }
     }
-    std::string line;
-    while (std::getline(file, line))
+    else
     {
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-        if (line.empty() || line[0] == '#')
-            continue;
-        ignorePatterns.push_back(line);
-	}
+        auto level = std::make_shared<Level>();
+        level->path = path;
+        levels.push_front(std::move(level));
+        levelIndex[path] = levels.begin();
+
+        if (levels.size() > MAX_CACHED_LEVELS)
+        {
+            levelIndex.erase(levels.back()->path);
+            levels.pop_back();
+            stats.evictions++;
+        }
+    }
+
+    std::shared_ptr<Level>& level = levels.front();
+    std::string content;
+    if (!fingerprint.exists || !ReadContent(path, content))
+    {
+        if (level->fingerprint.exists || !level->matcher.Empty())
+        {
+            // The stack of another directory may still hold the old level
+            level = std::make_shared<Level>();
+            level->path = path;
+        }
+        return level;
+    }
 
-	file.close();
-	currentParent = std::filesystem::path(gitignorePath).parent_path().string();
+    // Touched or rewritten with the same content, e.g. by a checkout
+    fingerprint.hash = HashContent(content);
+    if (level->fingerprint.exists && level->fingerprint.hash == fingerprint.hash)
+    {
+        level->fingerprint = fingerprint;
+        stats.rehashes++;
+        return level;
+    }
+
+    stats.compiles++;
+    auto compiled = std::make_shared<Level>();
+    compiled->path = path;
+    compiled->fingerprint = fingerprint;
+    compiled->matcher.AddPatterns(content);
+    level = std::move(compiled);
+    return level;
 }
 
-static std::regex ConvertPatternToRegex(std::string& strRex, const std::string& pattern) {
-    std::string rx = pattern;
-    std::replace(rx.begin(), rx.end(), '\\', '/');
+std::string FileFilter::FindGlobalExcludes()
+{
+    // core.excludesFile of the user configuration, otherwise the XDG default.
+    // It is resolved once, like git does per command
+#ifdef _WIN32
+    const char* home = std::getenv("USERPROFILE");
+#else
+    const char* home = std::getenv("HOME");
+#endif
+    if (!home || !*home)
+        return std::string();
 
-    if (!rx.empty() && rx[0] == '/')
-        rx.erase(0, 1);
+    std::ifstream config(fs::path(home) / ".gitconfig");
+    std::string line;
+    bool inCore = false;
+    while (std::getline(config, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
 
-    rx = std::regex_replace(rx, std::regex(R"(\*\*)"), R"(.*)");
-    rx = std::regex_replace(rx, std::regex(R"(\*)"), R"([^/]*)");
-    rx = std::regex_replace(rx, std::regex(R"(\?)"), R"([^/])");
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos)
+            continue;
+        if (line[start] == '[')
+        {
+            inCore = line.compare(start, 6, "[core]") == 0;
+            continue;
+        }
+        if (!inCore)
+            continue;
 
-    strRex = rx;
-    return std::regex(rx);
-}
+        size_t equals = line.find('=', start);
+        if (equals == std::string::npos)
+            continue;
+        std::string key = line.substr(start, line.find_last_not_of(" \t", equals - 1) + 1 - start);
+        std::transform(key.begin(), key.end(), key.begin(),
+            [](char c) { return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c); });
+        if (key != "excludesfile")
+            continue;
 
-bool FileFilter::MatchesPattern(const std::string& pattern, const std::string& filePath) const {
-    std::filesystem::path file(filePath);
-    std::filesystem::path base(currentParent);
+        size_t valueStart = line.find_first_not_of(" \t\"", equals + 1);
+        size_t valueEnd = line.find_last_not_of(" \t\"");
+        if (valueStart == std::string::npos || valueEnd < valueStart)
+            return std::string();
 
-    std::error_code ec;
-    std::filesystem::path relative = std::filesystem::relative(file, base, ec);
-    if (ec) relative = file.filename();
+        std::string value = line.substr(valueStart, valueEnd - valueStart + 1);
+        if (value.size() >= 2 && value[0] == '~' && (value[1] == '/' || value[1] == '\\'))
+            value = (fs::path(home) / value.substr(2)).string();
+        return value;
+    }
 
-    std::string normalized = relative.string();
-    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    const char* xdg = std::getenv("XDG_CONFIG_HOME");
+    if (xdg && *xdg)
+        return (fs::path(xdg) / "git" / "ignore").string();
+    return (fs::path(home) / ".config" / "git" / "ignore").string();
+}
 
-	std::string patternRegex;
-    std::regex rx = ConvertPatternToRegex(patternRegex, pattern);
-    bool result = std::regex_search(normalized, rx);
+bool FileFilter::ReadContent(const std::string& path, std::string& content)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
 
-    return result;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
 }
 
-void FileFilter::Clean()
+uint64_t FileFilter::HashContent(const std::string& content) noexcept
 {
-    ignorePatterns.clear();
-	currentParent.clear();
+    // FNV-1a, only used to detect changes
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : content)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
 }
@@ -1,4 +1,4 @@
-// Copyright (C) 2025 Zukaritasu
+// Copyright (C) 2025 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -15,26 +15,111 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
 #include <algorithm>
+#include <unordered_map>
 
+#include "GitignoreMatcher.hpp"
+
+struct FileFilterStats
+{
+    uint64_t hits = 0;       // Fingerprint unchanged, nothing was read
+    uint64_t rehashes = 0;   // Size or time changed but the content did not
+    uint64_t compiles = 0;   // The file was parsed and compiled
+    uint64_t evictions = 0;  // Compiled files dropped from the LRU
+};
+
+/**
+ * Decides if a file is private with the same ignore files that git reads,
+ * from lowest to highest precedence: the global excludes file,
+ * .git/info/exclude, and the .gitignore of the repository root and of every
+ * directory down to the file.
+ *
+ * Every ignore file is a level compiled once and shared by all the
+ * directories below it; selecting another directory only checks the
+ * fingerprint of the levels on its path.
+ */
 class FileFilter
 {
 public:
+    // Number of ignore files kept compiled, including the missing ones of
+    // directories without a .gitignore
+    static constexpr size_t MAX_CACHED_LEVELS = 64;
+
     FileFilter() = default;
     virtual ~FileFilter() = default;
 
     bool IsPrivate(const std::string& filePath) const;
+
+    /**
+     * @brief Selects the ignore files that apply to the files of a directory
+     * @param directory Directory of the current file
+     * @param root Top directory of the workspace, the repository root if
+     * there is one
+     * @param isRepository true if root contains .git, the exclude files are
+     * only read for repositories
+     */
+    void SelectDirectory(const std::string& directory, const std::string& root, bool isRepository);
+
+    /**
+     * @brief Selects a single .gitignore file, relative to its directory
+     */
     void LoadGitignore(const std::string& gitignorePath);
 
+    const FileFilterStats& GetStats() const noexcept { return stats; }
+
 private:
-    std::vector<std::string> ignorePatterns;
-	std::string currentParent;
+    struct Fingerprint
+    {
+        bool exists = false;
+        uintmax_t size = 0;
+        std::filesystem::file_time_type time{};
+        uint64_t hash = 0;
+    };
+
+    // One compiled ignore file
+    struct Level
+    {
+        std::string path;
+        Fingerprint fingerprint;
+        GitignoreMatcher matcher;
+
+        Level();
+    };
+
+    struct StackEntry
+    {
+        std::shared_ptr<const Level> level;
+        // Directory the patterns are relative to, normalized like the paths
+        // given to the matcher
+        std::string base;
+    };
+
+    // Most recently used first. The stack shares the levels, so evicting
+    // one never invalidates the current selection
+    std::list<std::shared_ptr<Level>> levels;
+    std::unordered_map<std::string, std::list<std::shared_ptr<Level>>::iterator> levelIndex;
+
+    // Lowest precedence first, only levels with patterns
+    std::vector<StackEntry> stack;
+    std::string stackRoot;
+
+    std::string globalExcludes;
+    bool globalExcludesResolved = false;
+    FileFilterStats stats{};
+
+    std::shared_ptr<Level> Acquire(const std::string& path);
+    void Push(const std::string& path, const std::string& base);
+    GitignoreMatcher::Result Decide(std::string_view path, bool isDirectory) const noexcept;
 
-    bool MatchesPattern(const std::string& pattern, const std::string& path) const;
-    void Clean();
+    static std::string FindGlobalExcludes();
+    static bool ReadContent(const std::string& path, std::string& content);
+    static uint64_t HashContent(const std::string& content) noexcept;
 };
@@ -0,0 +1,393 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "GitignoreMatcher.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    char ToLowerAscii(char c) noexcept
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool HasSlash(std::string_view s) noexcept
+    {
+        return s.find('/') != std::string_view::npos;
+    }
+}
+
+void GitignoreMatcher::AddPatterns(std::string_view content)
+{
+    while (!content.empty())
+    {
+        size_t end = content.find('\n');
+        AddPattern(content.substr(0, end));
+        if (end == std::string_view::npos)
+            break;
+        content.remove_prefix(end + 1);
+    }
+}
+
+void GitignoreMatcher::AddPattern(std::string_view line)
+{
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+        line.remove_suffix(1);
+    if (line.empty() || line[0] == '#')
+        return;
+
+    // Trailing spaces are ignored unless they are escaped with a backslash
+    while (!line.empty() && line.back() == ' ' &&
+           !(line.size() >= 2 && line[line.size() - 2] == '\\'))
+        line.remove_suffix(1);
+    if (line.empty())
+        return;
+
+    Pattern pattern;
+    if (line[0] == '!')
+    {
+        pattern.flags |= NEGATED;
+        line.remove_prefix(1);
+    }
+
+    if (!line.empty() && line.back() == '/')
+    {
+        pattern.flags |= DIR_ONLY;
+        line.remove_suffix(1);
+    }
+
+    if (HasSlash(line))
+    {
+        pattern.flags |= ANCHORED;
+        if (line[0] == '/')
+            line.remove_prefix(1);
+    }
+
+    if (line.empty())
+        return;
+
+    std::string glob(line);
+    if (_ignoreCase)
+        std::transform(glob.begin(), glob.end(), glob.begin(), ToLowerAscii);
+
+    Compile(glob, pattern);
+    _patterns.push_back(std::move(pattern));
+}
+
+void GitignoreMatcher::Compile(std::string_view glob, Pattern& pattern)
+{
+    std::vector<Instruction>& program = pattern.program;
+
+    for (size_t i = 0; i < glob.size(); i++)
+    {
+        char c = glob[i];
+        switch (c)
+        {
+        case '\\':
+            if (i + 1 < glob.size())
+                c = glob[++i];
+            program.push_back({ Op::Char, c, 0 });
+            break;
+        case '?':
+            program.push_back({ Op::AnyChar, 0, 0 });
+            break;
+        case '*':
+        {
+            size_t stars = 1;
+            while (i + 1 < glob.size() && glob[i + 1] == '*')
+            {
+                stars++;
+                i++;
+            }
+
+            // "**" only has a special meaning as a whole path component
+            const bool atComponentStart = (i + 1 == stars) || glob[i - stars] == '/';
+            const bool atComponentEnd = (i + 1 == glob.size()) || glob[i + 1] == '/';
+            if (stars >= 2 && atComponentStart && atComponentEnd)
+            {
+                if (i + 1 < glob.size())
+                {
+                    program.push_back({ Op::AnyDirs, 0, 0 });
+                    i++; // the '/' is part of AnyDirs
+                }
+                else
+                {
+                    program.push_back({ Op::AnyPath, 0, 0 });
+                }
+            }
+            else
+            {
+                program.push_back({ Op::Star, 0, 0 });
+            }
+            break;
+        }
+        case '[':
+        {
+            CharClass charClass;
+            size_t j = i + 1;
+            if (j < glob.size() && (glob[j] == '!' || glob[j] == '^'))
+            {
+                charClass.negated = true;
+                j++;
+            }
+
+            bool closed = false;
+            bool first = true;
+            for (; j < glob.size(); j++)
+            {
+                char lo = glob[j];
+                if (lo == ']' && !first)
+                {
+                    closed = true;
+                    break;
+                }
+                first = false;
+
+                if (lo == '\\' && j + 1 < glob.size())
+                    lo = glob[++j];
+
+                char hi = lo;
+                if (j + 2 < glob.size() && glob[j + 1] == '-' && glob[j + 2] != ']')
+                {
+                    hi = glob[j + 2];
+                    j += 2;
+                }
+
+                for (int b = static_cast<unsigned char>(lo); b <= static_cast<unsigned char>(hi); b++)
+                {
+                    charClass.bits[b >> 3] |= static_cast<uint8_t>(1u << (b & 7));
+                    if (_ignoreCase && b >= 'A' && b <= 'Z')
+                    {
+                        int lower = b - 'A' + 'a';
+                        charClass.bits[lower >> 3] |= static_cast<uint8_t>(1u << (lower & 7));
+                    }
+                }
+            }
+
+            if (!closed)
+            {
+                // Not a class, the '[' is a literal character
+                program.push_back({ Op::Char, '[', 0 });
+                break;
+            }
+
+            program.push_back({ Op::Class, 0, static_cast<uint16_t>(_classes.size()) });
+            _classes.push_back(charClass);
+            i = j;
+            break;
+        }
+        default:
+            program.push_back({ Op::Char, c, 0 });
+            break;
+        }
+    }
+
+    // Most real-world patterns are plain names or "*.ext", those are reduced
+    // to a single string comparison
+    auto isChar = [](const Instruction& in) { return in.op == Op::Char; };
+    const size_t size = program.size();
+
+    if (std::all_of(program.begin(), program.end(), isChar))
+        pattern.kind = Kind::Exact;
+    else if (size >= 2 && program.front().op == Op::Star && std::all_of(program.begin() + 1, program.end(), isChar))
+        pattern.kind = Kind::Suffix;
+    else if (size >= 2 && program.back().op == Op::Star && std::all_of(program.begin(), program.end() - 1, isChar))
+        pattern.kind = Kind::Prefix;
+    else
+        pattern.kind = Kind::Glob;
+
+    if (pattern.kind != Kind::Glob)
+    {
+        for (const Instruction& in : program)
+            if (in.op == Op::Char)
+                pattern.literal.push_back(in.c);
+        program.clear();
+        program.shrink_to_fit();
+        return;
+    }
+
+    // The literal ends of a glob reject most paths before running it
+    for (size_t i = 0; i < size && program[i].op == Op::Char; i++)
+        pattern.globPrefix.push_back(program[i].c);
+    for (size_t i = size; i > 0 && program[i - 1].op == Op::Char; i--)
+        pattern.globSuffix.insert(pattern.globSuffix.begin(), program[i - 1].c);
+}
+
+GitignoreMatcher::Result GitignoreMatcher::Match(std::string_view relativePath, bool isDirectory) const noexcept
+{
+    if (relativePath.empty())
+        return Result::None;
+
+    // The last matching pattern decides
+    for (auto it = _patterns.rbegin(); it != _patterns.rend(); ++it)
+    {
+        if ((it->flags & DIR_ONLY) && !isDirectory)
+            continue;
+        if (Matches(*it, relativePath))
+            return (it->flags & NEGATED) ? Result::Included : Result::Ignored;
+    }
+    return Result::None;
+}
+
+bool GitignoreMatcher::IsIgnored(std::string_view relativePath) const noexcept
+{
+    if (_patterns.empty())
+        return false;
+
+    for (size_t pos = relativePath.find('/'); pos != std::string_view::npos;
+         pos = relativePath.find('/', pos + 1))
+    {
+        if (Match(relativePath.substr(0, pos), true) == Result::Ignored)
+            return true;
+    }
+    return Match(relativePath, false) == Result::Ignored;
+}
+
+bool GitignoreMatcher::Matches(const Pattern& pattern, std::string_view path) const noexcept
+{
+    std::string_view text = path;
+    if (!(pattern.flags & ANCHORED))
+    {
+        // Patterns without a slash match the name at any level
+        size_t slash = path.find_last_of('/');
+        if (slash != std::string_view::npos)
+            text = path.substr(slash + 1);
+    }
+
+    const std::string& literal = pattern.literal;
+    switch (pattern.kind)
+    {
+    case Kind::Exact:
+        return text == literal;
+    case Kind::Suffix:
+        return text.size() >= literal.size() &&
+               text.compare(text.size() - literal.size(), literal.size(), literal) == 0 &&
+               !HasSlash(text.substr(0, text.size() - literal.size()));
+    case Kind::Prefix:
+        return text.size() >= literal.size() &&
+               text.compare(0, literal.size(), literal) == 0 &&
+               !HasSlash(text.substr(literal.size()));
+    case Kind::Glob:
+    default:
+        if (text.size() < pattern.globPrefix.size() + pattern.globSuffix.size() ||
+            text.compare(0, pattern.globPrefix.size(), pattern.globPrefix) != 0 ||
+            text.compare(text.size() - pattern.globSuffix.size(), pattern.globSuffix.size(), pattern.globSuffix) != 0)
+            return false;
+        return RunProgram(pattern.program, text);
+    }
+}
+
+bool GitignoreMatcher::RunProgram(const std::vector<Instruction>& program, std::string_view text) const noexcept
+{
+    // Simulates the automaton with one active flag per instruction, so the
+    // cost is O(text * program) without backtracking
+    const size_t states = program.size() + 1;
+
+    constexpr size_t STACK_STATES = 128;
+    uint8_t stackBuffer[2][STACK_STATES];
+    std::vector<uint8_t> heapBuffer;
+    uint8_t* current = stackBuffer[0];
+    uint8_t* next = stackBuffer[1];
+    if (states > STACK_STATES)
+    {
+        try
+        {
+            heapBuffer.resize(states * 2);
+        }
+        catch (...)
+        {
+            return false;
+        }
+        current = heapBuffer.data();
+        next = heapBuffer.data() + states;
+    }
+
+    // A state is ENTERED when it was reached without consuming input for
+    // it yet. AnyDirs can only be skipped (empty match) from that state,
+    // once it consumed characters it must end with a '/'
+    constexpr uint8_t ENTERED = 1, CONSUMED = 2;
+
+    auto closure = [&program, states](uint8_t* set) {
+        // Star, AnyPath and AnyDirs can match an empty sequence
+        for (size_t i = 0; i + 1 < states; i++)
+        {
+            const Op op = program[i].op;
+            if ((op == Op::Star || op == Op::AnyPath) && set[i])
+                set[i + 1] |= ENTERED;
+            else if (op == Op::AnyDirs && (set[i] & ENTERED))
+                set[i + 1] |= ENTERED;
+        }
+    };
+
+    std::fill(current, current + states, uint8_t(0));
+    current[0] = ENTERED;
+    closure(current);
+
+    for (char c : text)
+    {
+        std::fill(next, next + states, uint8_t(0));
+        bool any = false;
+
+        for (size_t i = 0; i + 1 < states; i++)
+        {
+            if (!current[i])
+                continue;
+
+            const Instruction& in = program[i];
+            switch (in.op)
+            {
+            case Op::Char:
+                if (c == in.c)
+                    next[i + 1] |= ENTERED;
+                break;
+            case Op::AnyChar:
+                if (c != '/')
+                    next[i + 1] |= ENTERED;
+                break;
+            case Op::Class:
+            {
+                const CharClass& cls = _classes[in.classIndex];
+                const unsigned char b = static_cast<unsigned char>(c);
+                const bool inClass = (cls.bits[b >> 3] >> (b & 7)) & 1;
+                if (c != '/' && inClass != cls.negated)
+                    next[i + 1] |= ENTERED;
+                break;
+            }
+            case Op::Star:
+                if (c != '/')
+                    next[i] |= CONSUMED;
+                break;
+            case Op::AnyPath:
+                next[i] |= CONSUMED;
+                break;
+            case Op::AnyDirs:
+                next[i] |= CONSUMED;
+                if (c == '/')
+                    next[i + 1] |= ENTERED;
+                break;
+            }
+        }
+
+        closure(next);
+        for (size_t i = 0; i < states && !any; i++)
+            any = next[i] != 0;
+        if (!any)
+            return false;
+        std::swap(current, next);
+    }
+
+    return current[states - 1] != 0;
+}
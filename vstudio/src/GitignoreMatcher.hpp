@@ -0,0 +1,137 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Set of .gitignore patterns compiled once into small glob programs.
+ *
+ * Supports the gitignore semantics: negation with '!', directory-only
+ * patterns with a trailing '/', patterns anchored to the .gitignore
+ * directory when they contain a '/', '**' for any number of directories,
+ * '*', '?', character classes and backslash escapes. Plain names, "*.ext"
+ * suffixes and "name*" prefixes are matched with a single comparison; other
+ * patterns run a glob automaton whose cost is linear in the path length.
+ */
+class GitignoreMatcher
+{
+public:
+    enum class Result
+    {
+        None,     // No pattern matches the path
+        Ignored,  // The last matching pattern excludes the path
+        Included  // The last matching pattern is a negation
+    };
+
+    explicit GitignoreMatcher(bool ignoreCase = false) noexcept : _ignoreCase(ignoreCase) {}
+
+    /**
+     * @brief Compiles one line of a .gitignore file
+     * @details Blank lines and comments are skipped
+     */
+    void AddPattern(std::string_view line);
+
+    /**
+     * @brief Compiles every line of the content of a .gitignore file
+     */
+    void AddPatterns(std::string_view content);
+
+    void Clear() noexcept
+    {
+        _patterns.clear();
+        _classes.clear();
+    }
+    bool Empty() const noexcept { return _patterns.empty(); }
+    size_t Size() const noexcept { return _patterns.size(); }
+    bool IgnoreCase() const noexcept { return _ignoreCase; }
+
+    /**
+     * @brief Evaluates the patterns against a single path
+     * @param relativePath Path relative to the .gitignore directory, with '/'
+     * separators and no leading '/'. Must be lower case if IgnoreCase()
+     * @param isDirectory true if the path names a directory
+     */
+    Result Match(std::string_view relativePath, bool isDirectory) const noexcept;
+
+    /**
+     * @brief Checks if a file is ignored, either by a pattern or because one
+     * of its parent directories is ignored (git cannot re-include a file
+     * whose parent directory is excluded)
+     * @param relativePath Same requirements as in Match
+     */
+    bool IsIgnored(std::string_view relativePath) const noexcept;
+
+private:
+    enum Flags : uint8_t
+    {
+        NEGATED  = 1 << 0, // "!pattern"
+        DIR_ONLY = 1 << 1, // "pattern/"
+        ANCHORED = 1 << 2  // Contains a '/', matched against the whole path
+    };
+
+    enum class Kind : uint8_t
+    {
+        Exact,  // "name"
+        Suffix, // "*.ext"
+        Prefix, // "name*"
+        Glob    // Anything else, runs the glob program
+    };
+
+    enum class Op : uint8_t
+    {
+        Char,    // Literal character
+        AnyChar, // '?'
+        Class,   // '[...]'
+        Star,    // '*', any sequence without '/'
+        AnyPath, // "**", any sequence
+        AnyDirs  // "**/", empty or any sequence ending with '/'
+    };
+
+    struct Instruction
+    {
+        Op op;
+        char c;             // Literal character for Op::Char
+        uint16_t classIndex; // Index into _classes for Op::Class
+    };
+
+    struct CharClass
+    {
+        bool negated = false;
+        uint8_t bits[32] = {}; // One bit per byte value
+    };
+
+    struct Pattern
+    {
+        uint8_t flags = 0;
+        Kind kind = Kind::Glob;
+        std::string literal;          // Exact, Suffix and Prefix kinds
+        std::string globPrefix;       // Glob kind: leading literal characters
+        std::string globSuffix;       // Glob kind: trailing literal characters
+        std::vector<Instruction> program;
+    };
+
+    std::vector<Pattern> _patterns;
+    std::vector<CharClass> _classes;
+    bool _ignoreCase;
+
+    void Compile(std::string_view glob, Pattern& pattern);
+    bool Matches(const Pattern& pattern, std::string_view path) const noexcept;
+    bool RunProgram(const std::vector<Instruction>& program, std::string_view text) const noexcept;
+};
@@ -0,0 +1,229 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "InstanceArbiter.hpp"
+
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Other processes map the same memory, the atomics must not need a lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics need lock-free 64-bit operations");
+static_assert(std::atomic<int64_t>::is_always_lock_free, "shared atomics need lock-free 64-bit operations");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics need lock-free 32-bit operations");
+
+namespace
+{
+    constexpr int64_t STALE_TICKS = std::chrono::duration_cast<InstanceArbiter::Clock::duration>(
+        InstanceArbiter::STALE_AFTER).count();
+
+    int64_t Ticks(InstanceArbiter::Clock::time_point time) noexcept
+    {
+        return time.time_since_epoch().count();
+    }
+
+    bool IsLive(const ArbiterSlot& slot, uint64_t token, int64_t now) noexcept
+    {
+        return token != 0 && now - slot.seen.load(std::memory_order_acquire) < STALE_TICKS;
+    }
+}
+
+InstanceArbiter::~InstanceArbiter()
+{
+    Close();
+    Unmap();
+}
+
+bool InstanceArbiter::Open(int64_t clientId, Clock::time_point lastActivity) noexcept
+{
+    Close();
+    Unmap();
+    if (!Map(clientId))
+        return false;
+
+    _lastActivity.store(Ticks(lastActivity), std::memory_order_relaxed);
+    if (!Claim(Ticks(Clock::now())))
+    {
+        Unmap();
+        return false;
+    }
+    _open.store(true, std::memory_order_release);
+    return true;
+}
+
+void InstanceArbiter::Close() noexcept
+{
+    _open.store(false, std::memory_order_release);
+    ArbiterSlot* slot = _slot.exchange(nullptr);
+    if (!slot)
+        return;
+
+    // The entry may have been taken over meanwhile, only a claim of this
+    // process is freed
+    uint64_t token = _token.load(std::memory_order_relaxed);
+    slot->token.compare_exchange_strong(token, 0);
+}
+
+void InstanceArbiter::Touch(Clock::time_point now) noexcept
+{
+    _lastActivity.store(Ticks(now), std::memory_order_relaxed);
+    ArbiterSlot* slot = _slot.load(std::memory_order_acquire);
+    if (!_open.load(std::memory_order_acquire) || !slot)
+        return;
+
+    // An entry that another process took over keeps the activity of that
+    // process, Refresh claims a new one with the activity stored above
+    if (slot->token.load(std::memory_order_acquire) == _token.load(std::memory_order_acquire))
+        slot->lastActivity.store(Ticks(now), std::memory_order_release);
+}
+
+void InstanceArbiter::Refresh(Clock::time_point now) noexcept
+{
+    if (!_open.load(std::memory_order_acquire))
+        return;
+
+    ArbiterSlot* slot = _slot.load(std::memory_order_acquire);
+    if (slot && slot->token.load(std::memory_order_acquire) == _token.load(std::memory_order_relaxed))
+        slot->seen.store(Ticks(now), std::memory_order_release);
+    else
+        Claim(Ticks(now));
+}
+
+bool InstanceArbiter::IsOwner(Clock::time_point now) const noexcept
+{
+    const ArbiterSlot* mine = _slot.load(std::memory_order_acquire);
+    if (!_open.load(std::memory_order_acquire) || !mine)
+        return true;
+    const uint64_t myToken = _token.load(std::memory_order_relaxed);
+    if (mine->token.load(std::memory_order_acquire) != myToken)
+        return false; // Claimed again at the next refresh
+
+    const int64_t ticks = Ticks(now);
+    const int64_t activity = mine->lastActivity.load(std::memory_order_acquire);
+    for (const ArbiterSlot& slot : _table->slots)
+    {
+        const uint64_t token = slot.token.load(std::memory_order_acquire);
+        if (&slot == mine || !IsLive(slot, token, ticks))
+            continue;
+
+        const int64_t other = slot.lastActivity.load(std::memory_order_acquire);
+        if (other > activity || (other == activity && token < myToken))
+            return false;
+    }
+    return true;
+}
+
+bool InstanceArbiter::Claim(int64_t now) noexcept
+{
+    // Tokens are never reused, a process that claims an entry of a stale
+    // one cannot be mistaken for it
+    const uint64_t token = _table->nextToken.fetch_add(1) + 1;
+    for (ArbiterSlot& slot : _table->slots)
+    {
+        uint64_t current = slot.token.load(std::memory_order_acquire);
+        if (IsLive(slot, current, now))
+            continue;
+        if (!slot.token.compare_exchange_strong(current, token))
+            continue;
+
+        slot.seen.store(now, std::memory_order_release);
+        slot.lastActivity.store(_lastActivity.load(std::memory_order_relaxed), std::memory_order_release);
+        _token.store(token, std::memory_order_release);
+        _slot.store(&slot, std::memory_order_release);
+        return true;
+    }
+    _slot.store(nullptr, std::memory_order_release);
+    return false;
+}
+
+bool InstanceArbiter::Map(int64_t clientId) noexcept
+{
+    void* view = nullptr;
+    try
+    {
+#ifdef _WIN32
+        // Local: the processes of the session of the user, as the pipe of
+        // Discord. The memory of a new mapping is zeroed
+        const std::wstring name = L"Local\\DiscordRPC-" + std::to_wstring(clientId);
+        HANDLE mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            0, static_cast<DWORD>(sizeof(ArbiterTable)), name.c_str());
+        if (!mapping)
+            return false;
+        view = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(ArbiterTable));
+        if (!view)
+        {
+            ::CloseHandle(mapping);
+            return false;
+        }
+        _mapping = mapping;
+#else
+        // Short name, macOS limits it to 31 characters. A new object is
+        // zeroed by ftruncate
+        const std::string name = "/drpc-" + std::to_string(::getuid()) + "-" + std::to_string(clientId);
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (::fstat(fd, &info) != 0 ||
+            (info.st_size < static_cast<off_t>(sizeof(ArbiterTable)) && ::ftruncate(fd, sizeof(ArbiterTable)) != 0))
+        {
+            ::close(fd);
+            return false;
+        }
+        view = ::mmap(nullptr, sizeof(ArbiterTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED)
+            return false;
+#endif
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    _table = static_cast<ArbiterTable*>(view);
+
+    // A process of another version of the plugin may have created the
+    // table with another layout
+    uint32_t version = 0;
+    if (!_table->version.compare_exchange_strong(version, ArbiterTable::LAYOUT_VERSION) &&
+        version != ArbiterTable::LAYOUT_VERSION)
+    {
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+void InstanceArbiter::Unmap() noexcept
+{
+    if (!_table)
+        return;
+#ifdef _WIN32
+    ::UnmapViewOfFile(_table);
+    ::CloseHandle(static_cast<HANDLE>(_mapping));
+#else
+    ::munmap(_table, sizeof(ArbiterTable));
+#endif
+    _table = nullptr;
+    _mapping = nullptr;
+}
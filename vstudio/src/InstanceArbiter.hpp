@@ -0,0 +1,125 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Entry of an editor process in the shared table. The token identifies the
+ * claim, 0 marks a free entry
+ */
+struct ArbiterSlot
+{
+    std::atomic<uint64_t> token;
+    std::atomic<int64_t> lastActivity; // steady_clock ticks of the last user activity
+    std::atomic<int64_t> seen;         // steady_clock ticks of the last refresh
+};
+
+/**
+ * Table shared by every process that shows a presence with the same
+ * application ID. It only holds lock-free atomics, it is read and written
+ * without a lock from any process
+ */
+struct ArbiterTable
+{
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr size_t MAX_INSTANCES = 16;
+
+    std::atomic<uint32_t> version; // 0 until the first process sets it
+    std::atomic<uint64_t> nextToken;
+    ArbiterSlot slots[MAX_INSTANCES];
+};
+
+/**
+ * Decides which of several editor processes talks to Discord. Every
+ * process publishes the time of its last user activity in a table in
+ * shared memory and only the most recently active one keeps a connection,
+ * so the windows do not take the activity from each other.
+ *
+ * Entries that are not refreshed for STALE_AFTER belong to a process that
+ * ended without closing, they are ignored and reused. steady_clock is the
+ * monotonic clock of the system on Windows and Linux, the times of two
+ * processes compare.
+ *
+ * Open, Refresh and Close are called by one thread; Touch may be called
+ * from any thread while the arbiter is open.
+ */
+class InstanceArbiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // How often the owner is checked and the entry refreshed
+    static constexpr std::chrono::milliseconds REFRESH_INTERVAL{ 500 };
+    static constexpr std::chrono::milliseconds STALE_AFTER{ 3000 };
+
+    InstanceArbiter() = default;
+    ~InstanceArbiter();
+
+    InstanceArbiter(const InstanceArbiter&) = delete;
+    InstanceArbiter& operator=(const InstanceArbiter&) = delete;
+
+    /**
+     * @brief Maps the table of the application ID and claims an entry
+     * @param lastActivity Time of the last user activity of this process
+     * @return false if there is no shared memory or every entry is taken,
+     * the process then always owns the connection
+     */
+    bool Open(int64_t clientId, Clock::time_point lastActivity) noexcept;
+
+    /**
+     * @brief Frees the entry, the other processes take over at their next
+     * refresh. The table stays mapped until the next Open or the
+     * destructor, a Touch running meanwhile never sees it unmapped
+     */
+    void Close() noexcept;
+
+    bool IsOpen() const noexcept { return _open.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Publishes a user activity of this process. The entry is only
+     * written while it is still claimed by this process
+     */
+    void Touch(Clock::time_point now) noexcept;
+
+    /**
+     * @brief Marks the entry as alive, an entry that was taken over while
+     * the process was not refreshing it is claimed again
+     */
+    void Refresh(Clock::time_point now) noexcept;
+
+    /**
+     * @brief Whether this process is the most recently active one. Ties go
+     * to the oldest claim; without a table it is always true
+     */
+    bool IsOwner(Clock::time_point now) const noexcept;
+
+private:
+    ArbiterTable* _table = nullptr;
+    void* _mapping = nullptr; // Platform handle of the shared memory
+    // Read by Touch from any thread, written by the thread that refreshes
+    std::atomic<bool> _open{ false };
+    std::atomic<ArbiterSlot*> _slot{ nullptr };
+    std::atomic<uint64_t> _token{ 0 };
+    std::atomic<int64_t> _lastActivity{ 0 };
+
+    bool Claim(int64_t now) noexcept;
+    bool Map(int64_t clientId) noexcept;
+    void Unmap() noexcept;
+};
@@ -0,0 +1,50 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "IpcTransport.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include "NamedPipeTransport.hpp"
+#else
+#include "UnixSocketTransport.hpp"
+#endif
+
+std::unique_ptr<IpcTransport> IpcTransport::CreateDefault()
+{
+#ifdef _WIN32
+    return std::make_unique<NamedPipeTransport>();
+#else
+    return std::make_unique<UnixSocketTransport>();
+#endif
+}
+
+size_t IpcTransport::TakeBuffered(void* data, size_t size) noexcept
+{
+    const size_t count = std::min(size, Buffered());
+    if (count > 0)
+    {
+        std::memcpy(data, _readBuffer.data() + _readOffset, count);
+        _readOffset += count;
+    }
+    if (_readOffset == _readBuffer.size())
+    {
+        _readBuffer.clear();
+        _readOffset = 0;
+    }
+    return count;
+}
@@ -0,0 +1,110 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Byte stream to the Discord client. The implementations only move bytes:
+ * the framing, the handshake and the messages are handled by
+ * DiscordRichPresence, so the same protocol code runs over a Windows named
+ * pipe or a Unix domain socket.
+ *
+ * A transport is used by one thread, except Wake which may be called from
+ * any thread to interrupt Wait.
+ */
+class IpcTransport
+{
+public:
+    static constexpr uint32_t INFINITE_TIMEOUT = 0xFFFFFFFF;
+    // Discord listens on discord-ipc-0 to discord-ipc-9
+    static constexpr int MAX_ENDPOINTS = 10;
+
+    enum class WaitResult
+    {
+        Readable, // Read will return data without waiting
+        Woken,    // Wake was called
+        Timeout,
+        Failed    // The connection was closed or broken
+    };
+
+    virtual ~IpcTransport() = default;
+
+    /**
+     * @brief Connects to the endpoint discord-ipc-<index>
+     * @return false if the endpoint does not exist or refused the connection
+     */
+    virtual bool Connect(int index) = 0;
+    virtual void Disconnect() noexcept = 0;
+    virtual bool IsConnected() const noexcept = 0;
+
+    /**
+     * @brief Writes the whole buffer
+     * @return false on timeout or error, the connection is then unusable
+     */
+    virtual bool Write(const void* data, size_t size, uint32_t timeoutMs) = 0;
+
+    /**
+     * @brief Reads exactly size bytes
+     * @return false on timeout or error, the connection is then unusable
+     */
+    virtual bool Read(void* data, size_t size, uint32_t timeoutMs) = 0;
+
+    /**
+     * @brief Waits until there is data to read, Wake is called or the
+     * timeout expires. Without a connection it only waits for Wake
+     */
+    virtual WaitResult Wait(uint32_t timeoutMs) = 0;
+
+    /**
+     * @brief Interrupts the current or the next Wait, thread safe
+     */
+    virtual void Wake() noexcept = 0;
+
+    /**
+     * @brief Checks which endpoints exist without connecting to them or
+     * waiting for them
+     * @return Bit N set if discord-ipc-N exists
+     */
+    virtual uint32_t ProbeEndpoints() const = 0;
+
+    /**
+     * @brief Name of the endpoint for the index, for error messages
+     */
+    virtual std::string Endpoint(int index) const = 0;
+
+    /**
+     * @brief Named pipe transport on Windows, Unix domain socket elsewhere
+     */
+    static std::unique_ptr<IpcTransport> CreateDefault();
+
+protected:
+    // Bytes received by Wait and not consumed by Read yet
+    std::vector<char> _readBuffer;
+    size_t _readOffset = 0;
+
+    size_t Buffered() const noexcept { return _readBuffer.size() - _readOffset; }
+
+    /**
+     * @brief Moves up to size buffered bytes to data
+     * @return Number of bytes moved
+     */
+    size_t TakeBuffered(void* data, size_t size) noexcept;
+};
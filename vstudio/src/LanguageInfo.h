@@ -1,4 +1,4 @@
-// Copyright (C) 2022 - 2023 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -17,6 +17,7 @@
 
 #include <string>
 
+constexpr auto NPP_NAME = "Notepad++";
 constexpr auto NPP_DEFAULTIMAGE = "favicon";
 constexpr auto NPP_IDLEIMAGE = "idle";
 
@@ -0,0 +1,79 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+/**
+ * Single value mailbox between any number of producers and one consumer.
+ * A value published before the consumer took the previous one replaces it,
+ * so the consumer only ever sees the latest value.
+ *
+ * Publishing is an atomic exchange. The consumer hands the taken node back
+ * with Recycle and the next Publish assigns into it, so in the steady state
+ * no memory is allocated either.
+ */
+template <typename T>
+class LatestSlot
+{
+public:
+    LatestSlot() = default;
+    LatestSlot(const LatestSlot&) = delete;
+    LatestSlot& operator=(const LatestSlot&) = delete;
+
+    ~LatestSlot()
+    {
+        delete _value.load(std::memory_order_acquire);
+        delete _spare.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Replaces the pending value
+     * @return true if a value that was not taken yet was dropped
+     */
+    bool Publish(const T& value)
+    {
+        std::unique_ptr<T> node(_spare.exchange(nullptr, std::memory_order_acquire));
+        if (node)
+            *node = value;
+        else
+            node.reset(new T(value));
+
+        T* dropped = _value.exchange(node.release(), std::memory_order_acq_rel);
+        if (dropped)
+            Recycle(dropped);
+        return dropped != nullptr;
+    }
+
+    /**
+     * @brief Takes the pending value, nullptr if there is none
+     * @details Pass the node to Recycle once it is no longer needed
+     */
+    T* Take() noexcept
+    {
+        return _value.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    void Recycle(T* node) noexcept
+    {
+        delete _spare.exchange(node, std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<T*> _value{ nullptr };
+    std::atomic<T*> _spare{ nullptr };
+};
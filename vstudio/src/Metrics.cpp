@@ -0,0 +1,163 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Metrics.hpp"
+
+#include <cstdio>
+
+std::atomic<bool> Metrics::_enabled{ false };
+LatencyHistogram Metrics::_histograms[STAGE_COUNT];
+
+namespace
+{
+    unsigned HighestBit(uint64_t value) noexcept
+    {
+        unsigned bit = 0;
+        for (unsigned shift = 32; shift > 0; shift /= 2)
+        {
+            if (value >> shift)
+            {
+                value >>= shift;
+                bit += shift;
+            }
+        }
+        return bit;
+    }
+
+    void AppendMicroseconds(std::string& out, uint64_t ns)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), " %11.1f", ns / 1000.0);
+        out += buffer;
+    }
+}
+
+size_t LatencyHistogram::BucketOf(uint64_t ns) noexcept
+{
+    if (ns < SUB_BUCKETS)
+        return static_cast<size_t>(ns);
+
+    const unsigned bit = HighestBit(ns);
+    const uint64_t subBucket = (ns >> (bit - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>((bit - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket);
+}
+
+uint64_t LatencyHistogram::LowerBound(size_t bucket) noexcept
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+
+    const unsigned bit = static_cast<unsigned>(bucket / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    return (SUB_BUCKETS + bucket % SUB_BUCKETS) << (bit - SUB_BUCKET_BITS);
+}
+
+void LatencyHistogram::Record(uint64_t ns) noexcept
+{
+    _buckets[BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t max = _max.load(std::memory_order_relaxed);
+    while (ns > max && !_max.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencySummary LatencyHistogram::Summarize() const noexcept
+{
+    // The buckets are read one by one while other threads may record, the
+    // totals are taken from them so the percentiles stay consistent
+    uint64_t counts[BUCKET_COUNT];
+    LatencySummary summary;
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        counts[i] = _buckets[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    if (summary.count == 0)
+        return summary;
+
+    summary.maxNs = _max.load(std::memory_order_relaxed);
+    summary.meanNs = _sum.load(std::memory_order_relaxed) / _count.load(std::memory_order_relaxed);
+
+    // Each percentile is the middle of the bucket that contains it
+    const double quantiles[] = { 0.50, 0.90, 0.99 };
+    uint64_t* const results[] = { &summary.p50Ns, &summary.p90Ns, &summary.p99Ns };
+    size_t bucket = 0;
+    uint64_t seen = counts[0];
+    for (size_t q = 0; q < 3; q++)
+    {
+        const uint64_t rank = static_cast<uint64_t>(quantiles[q] * (summary.count - 1)) + 1;
+        while (seen < rank && bucket + 1 < BUCKET_COUNT)
+            seen += counts[++bucket];
+
+        const uint64_t lower = LowerBound(bucket);
+        const uint64_t upper = bucket + 1 < BUCKET_COUNT ? LowerBound(bucket + 1) : lower;
+        const uint64_t middle = lower + (upper - lower) / 2;
+        *results[q] = middle < summary.maxNs ? middle : summary.maxNs;
+    }
+    return summary;
+}
+
+void LatencyHistogram::Reset() noexcept
+{
+    for (std::atomic<uint64_t>& bucket : _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+void Metrics::Record(MetricStage stage, std::chrono::steady_clock::duration elapsed) noexcept
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    _histograms[stage].Record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+}
+
+LatencySummary Metrics::Summarize(MetricStage stage) noexcept
+{
+    return _histograms[stage].Summarize();
+}
+
+void Metrics::Reset() noexcept
+{
+    for (LatencyHistogram& histogram : _histograms)
+        histogram.Reset();
+}
+
+void Metrics::WriteReport(std::string& out)
+{
+    char line[96];
+    std::snprintf(line, sizeof(line), "%-14s %10s %11s %11s %11s %11s %11s\n",
+        "Stage (us)", "Count", "Mean", "p50", "p90", "p99", "Max");
+    out += line;
+
+    for (size_t stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        const LatencySummary summary = Summarize(static_cast<MetricStage>(stage));
+        if (summary.count == 0)
+            continue;
+
+        std::snprintf(line, sizeof(line), "%-14s %10llu", METRIC_STAGE_NAMES[stage],
+            static_cast<unsigned long long>(summary.count));
+        out += line;
+        AppendMicroseconds(out, summary.meanNs);
+        AppendMicroseconds(out, summary.p50Ns);
+        AppendMicroseconds(out, summary.p90Ns);
+        AppendMicroseconds(out, summary.p99Ns);
+        AppendMicroseconds(out, summary.maxNs);
+        out += '\n';
+    }
+}
@@ -0,0 +1,142 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Stages of the hot path that are timed while the latency statistics are
+ * enabled
+ */
+enum MetricStage : uint8_t
+{
+    STAGE_NOTIFY,        // beNotified, any notification of the editor
+    STAGE_UPDATE,        // RichPresence::Update on the editor thread
+    STAGE_EDITOR_STATUS, // Properties read from Notepad++ and Scintilla
+    STAGE_RESOLVE,       // PresenceResolver::Resolve
+    STAGE_WORKSPACE,     // Workspace lookup and ignore file selection
+    STAGE_PRIVACY,       // FileFilter::IsPrivate
+    STAGE_RENDER,        // A format rendered into a field
+    STAGE_SERIALIZE,     // SET_ACTIVITY payload
+    STAGE_FRAME_WRITE,   // A frame written to the transport
+    STAGE_ROUND_TRIP,    // SET_ACTIVITY sent until Discord answers it
+    STAGE_COUNT
+};
+
+constexpr const char* METRIC_STAGE_NAMES[STAGE_COUNT] =
+{
+    "notify", "update", "editor_status", "resolve", "workspace",
+    "privacy", "render", "serialize", "frame_write", "round_trip"
+};
+
+struct LatencySummary
+{
+    uint64_t count = 0;
+    uint64_t meanNs = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p90Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t maxNs = 0;
+};
+
+/**
+ * Log-linear histogram of durations in nanoseconds. Every power of two is
+ * split in SUB_BUCKETS buckets, so a percentile is within 1/SUB_BUCKETS of
+ * the real value at any scale. Recording is a few relaxed atomic
+ * additions, any thread may record while another one reads.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(uint64_t ns) noexcept;
+    LatencySummary Summarize() const noexcept;
+    void Reset() noexcept;
+
+    static size_t BucketOf(uint64_t ns) noexcept;
+    // Smallest value that falls in the bucket
+    static uint64_t LowerBound(size_t bucket) noexcept;
+
+private:
+    std::atomic<uint64_t> _buckets[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> _count{ 0 };
+    std::atomic<uint64_t> _sum{ 0 };
+    std::atomic<uint64_t> _max{ 0 };
+};
+
+/**
+ * Process-wide latency statistics. They are always compiled in; while they
+ * are disabled a timer costs one relaxed load and never reads the clock.
+ */
+class Metrics
+{
+public:
+    static bool Enabled() noexcept { return _enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled) noexcept { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    static void Record(MetricStage stage, std::chrono::steady_clock::duration elapsed) noexcept;
+    static LatencySummary Summarize(MetricStage stage) noexcept;
+    static void Reset() noexcept;
+
+    /**
+     * @brief Appends a table with the summary of every stage that recorded
+     * at least one duration
+     */
+    static void WriteReport(std::string& out);
+
+private:
+    static std::atomic<bool> _enabled;
+    static LatencyHistogram _histograms[STAGE_COUNT];
+};
+
+/**
+ * Records the lifetime of the scope in the histogram of a stage
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(MetricStage stage) noexcept
+        : _stage(stage), _enabled(Metrics::Enabled())
+    {
+        if (_enabled)
+            _start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer()
+    {
+        if (_enabled)
+            Metrics::Record(_stage, std::chrono::steady_clock::now() - _start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    MetricStage _stage;
+    bool _enabled;
+    std::chrono::steady_clock::time_point _start{};
+};
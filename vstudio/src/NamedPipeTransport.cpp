@@ -0,0 +1,256 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifdef _WIN32
+
+#include "NamedPipeTransport.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    DWORD Remaining(std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return 0;
+        return static_cast<DWORD>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+    }
+
+    // Waits for an overlapped operation, it is cancelled on timeout
+    bool Complete(HANDLE pipe, OVERLAPPED& ov, DWORD timeoutMs, DWORD& transferred) noexcept
+    {
+        if (::WaitForSingleObject(ov.hEvent, timeoutMs) != WAIT_OBJECT_0)
+        {
+            ::CancelIo(pipe);
+            ::GetOverlappedResult(pipe, &ov, &transferred, TRUE);
+            return false;
+        }
+        return ::GetOverlappedResult(pipe, &ov, &transferred, FALSE) != FALSE;
+    }
+}
+
+NamedPipeTransport::NamedPipeTransport() noexcept
+{
+    _wakeEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+NamedPipeTransport::~NamedPipeTransport()
+{
+    Disconnect();
+    if (_wakeEvent)
+        ::CloseHandle(_wakeEvent);
+}
+
+std::string NamedPipeTransport::Endpoint(int index) const
+{
+    return R"(\\.\pipe\discord-ipc-)" + std::to_string(index);
+}
+
+uint32_t NamedPipeTransport::ProbeEndpoints() const
+{
+    // Listing the pipe directory does not open the pipes, unlike
+    // WaitNamedPipe or GetFileAttributes, and costs one call for all of them
+    uint32_t found = 0;
+    WIN32_FIND_DATAA data;
+    HANDLE find = ::FindFirstFileA(R"(\\.\pipe\discord-ipc-*)", &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        constexpr size_t PREFIX_LENGTH = sizeof("discord-ipc-") - 1;
+        if (std::strncmp(data.cFileName, "discord-ipc-", PREFIX_LENGTH) != 0)
+            continue;
+        const char* suffix = data.cFileName + PREFIX_LENGTH;
+        if (suffix[0] >= '0' && suffix[0] <= '9' && suffix[1] == '\0')
+            found |= 1u << (suffix[0] - '0');
+    } while (::FindNextFileA(find, &data));
+    ::FindClose(find);
+    return found;
+}
+
+bool NamedPipeTransport::Connect(int index)
+{
+    Disconnect();
+
+    const std::string pipeName = Endpoint(index);
+    if (!::WaitNamedPipeA(pipeName.c_str(), 100))
+        return false;
+
+    _pipe = ::CreateFileA(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+                          FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, NULL);
+    if (_pipe == INVALID_HANDLE_VALUE)
+        return false;
+
+    // One event for the pending read and one for everything else, both live
+    // as long as the connection
+    _ioEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+    _readOverlapped = OVERLAPPED{};
+    _readOverlapped.hEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!_ioEvent || !_readOverlapped.hEvent)
+    {
+        Disconnect();
+        return false;
+    }
+    return true;
+}
+
+void NamedPipeTransport::Disconnect() noexcept
+{
+    if (_pipe != INVALID_HANDLE_VALUE)
+    {
+        if (_readPending)
+        {
+            // The kernel must be done with _chunk before it is reused
+            DWORD bytesRead = 0;
+            ::CancelIo(_pipe);
+            ::GetOverlappedResult(_pipe, &_readOverlapped, &bytesRead, TRUE);
+        }
+        ::CloseHandle(_pipe);
+        _pipe = INVALID_HANDLE_VALUE;
+    }
+    if (_readOverlapped.hEvent)
+    {
+        ::CloseHandle(_readOverlapped.hEvent);
+        _readOverlapped.hEvent = NULL;
+    }
+    if (_ioEvent)
+    {
+        ::CloseHandle(_ioEvent);
+        _ioEvent = NULL;
+    }
+    _readPending = false;
+    _readBuffer.clear();
+    _readOffset = 0;
+}
+
+bool NamedPipeTransport::Write(const void* data, size_t size, uint32_t timeoutMs)
+{
+    if (_pipe == INVALID_HANDLE_VALUE)
+        return false;
+
+    OVERLAPPED ov{};
+    ov.hEvent = _ioEvent;
+    ::ResetEvent(_ioEvent);
+
+    DWORD written = 0;
+    if (!::WriteFile(_pipe, data, static_cast<DWORD>(size), &written, &ov))
+    {
+        if (::GetLastError() != ERROR_IO_PENDING || !Complete(_pipe, ov, timeoutMs, written))
+            return false;
+    }
+    return written == size;
+}
+
+bool NamedPipeTransport::Read(void* data, size_t size, uint32_t timeoutMs)
+{
+    if (_pipe == INVALID_HANDLE_VALUE)
+        return false;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    char* out = static_cast<char*>(data);
+
+    // A read started by Wait comes first, it holds the oldest bytes
+    if (_readPending && !CompleteRead(timeoutMs))
+        return false;
+
+    size_t done = TakeBuffered(out, size);
+    while (done < size)
+    {
+        OVERLAPPED ov{};
+        ov.hEvent = _ioEvent;
+        ::ResetEvent(_ioEvent);
+
+        DWORD bytesRead = 0;
+        const DWORD wanted = static_cast<DWORD>(size - done);
+        if (!::ReadFile(_pipe, out + done, wanted, &bytesRead, &ov))
+        {
+            if (::GetLastError() != ERROR_IO_PENDING || !Complete(_pipe, ov, Remaining(deadline), bytesRead))
+                return false;
+        }
+        if (bytesRead == 0)
+            return false;
+        done += bytesRead;
+    }
+    return true;
+}
+
+IpcTransport::WaitResult NamedPipeTransport::Wait(uint32_t timeoutMs)
+{
+    if (Buffered() > 0)
+        return WaitResult::Readable;
+
+    if (_pipe != INVALID_HANDLE_VALUE && !_readPending && !StartRead())
+        return WaitResult::Failed;
+
+    HANDLE handles[] = { _wakeEvent, _readOverlapped.hEvent };
+    const DWORD count = _pipe != INVALID_HANDLE_VALUE ? 2 : 1;
+    switch (::WaitForMultipleObjects(count, handles, FALSE, timeoutMs == INFINITE_TIMEOUT ? INFINITE : timeoutMs))
+    {
+    case WAIT_OBJECT_0:
+        return WaitResult::Woken;
+    case WAIT_OBJECT_0 + 1:
+        return CompleteRead(0) ? WaitResult::Readable : WaitResult::Failed;
+    case WAIT_TIMEOUT:
+        return WaitResult::Timeout;
+    default:
+        return WaitResult::Failed;
+    }
+}
+
+void NamedPipeTransport::Wake() noexcept
+{
+    if (_wakeEvent)
+        ::SetEvent(_wakeEvent);
+}
+
+bool NamedPipeTransport::StartRead() noexcept
+{
+    ::ResetEvent(_readOverlapped.hEvent);
+    DWORD bytesRead = 0;
+    if (!::ReadFile(_pipe, _chunk, READ_CHUNK, &bytesRead, &_readOverlapped) &&
+        ::GetLastError() != ERROR_IO_PENDING)
+    {
+        return false;
+    }
+
+    // Even when the read completes at once the event is signaled, the
+    // result is always collected by CompleteRead
+    _readPending = true;
+    return true;
+}
+
+bool NamedPipeTransport::CompleteRead(DWORD timeoutMs) noexcept
+{
+    DWORD bytesRead = 0;
+    const bool completed = Complete(_pipe, _readOverlapped, timeoutMs, bytesRead);
+    _readPending = false;
+    if (!completed || bytesRead == 0)
+        return false;
+
+    try
+    {
+        _readBuffer.insert(_readBuffer.end(), _chunk, _chunk + bytesRead);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+    return true;
+}
+
+#endif // _WIN32
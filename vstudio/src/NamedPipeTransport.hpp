@@ -0,0 +1,63 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#include "IpcTransport.hpp"
+
+/**
+ * \\.\pipe\discord-ipc-N with overlapped I/O. Wait keeps one read pending,
+ * so data from Discord wakes the caller together with Wake.
+ */
+class NamedPipeTransport : public IpcTransport
+{
+public:
+    NamedPipeTransport() noexcept;
+    ~NamedPipeTransport() override;
+
+    NamedPipeTransport(const NamedPipeTransport&) = delete;
+    NamedPipeTransport& operator=(const NamedPipeTransport&) = delete;
+
+    bool Connect(int index) override;
+    void Disconnect() noexcept override;
+    bool IsConnected() const noexcept override { return _pipe != INVALID_HANDLE_VALUE; }
+    bool Write(const void* data, size_t size, uint32_t timeoutMs) override;
+    bool Read(void* data, size_t size, uint32_t timeoutMs) override;
+    WaitResult Wait(uint32_t timeoutMs) override;
+    void Wake() noexcept override;
+    uint32_t ProbeEndpoints() const override;
+    std::string Endpoint(int index) const override;
+
+private:
+    static constexpr DWORD READ_CHUNK = 4096;
+
+    HANDLE _pipe = INVALID_HANDLE_VALUE;
+    HANDLE _wakeEvent = NULL;
+    // Manual reset event of the connection for writes and direct reads
+    HANDLE _ioEvent = NULL;
+    // The pending read of Wait, it overlaps the writes
+    OVERLAPPED _readOverlapped{};
+    bool _readPending = false;
+    char _chunk[READ_CHUNK];
+
+    bool StartRead() noexcept;
+    bool CompleteRead(DWORD timeoutMs) noexcept;
+};
+
+#endif // _WIN32
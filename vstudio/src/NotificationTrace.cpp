@@ -0,0 +1,102 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "NotificationTrace.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+bool TraceWriter::Open(const std::filesystem::path& path, uint64_t now)
+{
+    Close();
+    _out.open(path, std::ios::out | std::ios::trunc);
+    if (!_out)
+        return false;
+    _start = now;
+    _out << HEADER << '\n';
+    return true;
+}
+
+void TraceWriter::Close()
+{
+    if (_out.is_open())
+        _out.close();
+    _out.clear();
+}
+
+void TraceWriter::Config(std::string_view name, std::string_view value)
+{
+    _out << "C " << name << ' ' << value << '\n';
+}
+
+void TraceWriter::Notification(uint64_t now, unsigned code)
+{
+    _out << "N " << (now >= _start ? now - _start : 0) << ' ' << code << '\n';
+}
+
+void TraceWriter::Answer(unsigned message, int64_t value)
+{
+    _out << "A " << message << ' ' << value << '\n';
+}
+
+void TraceWriter::Text(unsigned message, std::string_view text)
+{
+    _out << "T " << message << ' ' << text << '\n';
+}
+
+bool TraceReader::Next(TraceRecord& record)
+{
+    while (std::getline(_in, _buffer))
+    {
+        _line++;
+        if (!_buffer.empty() && _buffer.back() == '\r')
+            _buffer.pop_back();
+        if (_buffer.empty() || _buffer[0] == '#')
+            continue;
+
+        // Kind, a first field and the rest of the line
+        const size_t first = _buffer.find(' ');
+        const size_t second = first == std::string::npos ? std::string::npos : _buffer.find(' ', first + 1);
+        if (_buffer.size() < 2 || first != 1 || second == std::string::npos)
+            throw std::runtime_error("Invalid trace record at line " + std::to_string(_line));
+
+        const std::string field = _buffer.substr(first + 1, second - first - 1);
+        const std::string rest = _buffer.substr(second + 1);
+        record.kind = static_cast<TraceRecord::Kind>(_buffer[0]);
+        switch (record.kind)
+        {
+        case TraceRecord::CONFIG:
+            record.name = field;
+            record.text = rest;
+            break;
+        case TraceRecord::NOTIFICATION:
+            record.time = std::strtoull(field.c_str(), nullptr, 10);
+            record.code = static_cast<unsigned>(std::strtoul(rest.c_str(), nullptr, 10));
+            break;
+        case TraceRecord::ANSWER:
+            record.code = static_cast<unsigned>(std::strtoul(field.c_str(), nullptr, 10));
+            record.value = std::strtoll(rest.c_str(), nullptr, 10);
+            break;
+        case TraceRecord::TEXT:
+            record.code = static_cast<unsigned>(std::strtoul(field.c_str(), nullptr, 10));
+            record.text = rest;
+            break;
+        default:
+            throw std::runtime_error("Unknown trace record at line " + std::to_string(_line));
+        }
+        return true;
+    }
+    return false;
+}
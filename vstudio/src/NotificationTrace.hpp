@@ -0,0 +1,109 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+#include <istream>
+#include <string>
+#include <string_view>
+
+/**
+ * One line of a session trace. A trace holds the config of the session,
+ * the notifications that reached beNotified with their time, and the
+ * answers of every message the plugin sent to Notepad++ and Scintilla, in
+ * the order they happened. The answers that follow a notification are the
+ * editor state of the updates it caused.
+ */
+struct TraceRecord
+{
+    enum Kind : char
+    {
+        CONFIG       = 'C', // name = value of an option
+        NOTIFICATION = 'N', // time and notification code
+        ANSWER       = 'A', // message and its result, or the value written through lParam
+        TEXT         = 'T'  // message and the UTF-8 text written to its buffer
+    };
+
+    Kind kind = NOTIFICATION;
+    uint64_t time = 0; // Milliseconds since the recording started
+    unsigned code = 0; // Notification code or message
+    int64_t value = 0;
+    std::string name;  // CONFIG
+    std::string text;  // CONFIG value or TEXT
+};
+
+/**
+ * Writes a session trace, one record per line:
+ *
+ *     C <name> <value>
+ *     N <time> <code>
+ *     A <message> <value>
+ *     T <message> <text>
+ *
+ * The text is the rest of the line, the file names and paths that
+ * Notepad++ answers never contain a line break.
+ */
+class TraceWriter
+{
+public:
+    static constexpr const char* HEADER = "# DiscordRPC trace 1";
+
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    /**
+     * @brief Starts a new trace, the times are counted from now
+     * @return false if the file could not be created
+     */
+    bool Open(const std::filesystem::path& path, uint64_t now);
+    void Close();
+    bool IsOpen() const noexcept { return _out.is_open(); }
+
+    void Config(std::string_view name, std::string_view value);
+    void Notification(uint64_t now, unsigned code);
+    void Answer(unsigned message, int64_t value);
+    void Text(unsigned message, std::string_view text);
+
+private:
+    std::ofstream _out;
+    uint64_t _start = 0;
+};
+
+/**
+ * Reads the records of a trace written by TraceWriter
+ */
+class TraceReader
+{
+public:
+    explicit TraceReader(std::istream& in) : _in(in) {}
+
+    /**
+     * @brief Reads the next record, comments and blank lines are skipped
+     * @return false at the end of the trace
+     * @throws std::runtime_error if a line is not a valid record
+     */
+    bool Next(TraceRecord& record);
+
+    size_t GetLine() const noexcept { return _line; }
+
+private:
+    std::istream& _in;
+    std::string _buffer;
+    size_t _line = 0;
+};
@@ -1,4 +1,4 @@
-// Copyright (C) 2022 - 2025 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -37,6 +37,27 @@ PluginConfig& PluginConfig::operator=(const PluginConfig& pg)
 	return *this;
 }
 
+bool PluginConfig::operator==(const PluginConfig& pg) const
+{
+	return _client_id == pg._client_id &&
+		_refreshTime == pg._refreshTime &&
+		strcmp(_details_format, pg._details_format) == 0 &&
+		strcmp(_state_format, pg._state_format) == 0 &&
+		strcmp(_large_text_format, pg._large_text_format) == 0 &&
+		_enable == pg._enable &&
+		_hide_state == pg._hide_state &&
+		_lang_image == pg._lang_image &&
+		_elapsed_time == pg._elapsed_time &&
+		_hide_details == pg._hide_details &&
+		_button_repository == pg._button_repository &&
+		_hide_if_private == pg._hide_if_private &&
+		_hide_idle_status == pg._hide_idle_status &&
+		_latency_stats == pg._latency_stats &&
+		_arbitrate_instances == pg._arbitrate_instances &&
+		_idle_time == pg._idle_time &&
+		_heartbeat_interval == pg._heartbeat_interval;
+}
+
 void ConfigManager::LoadDefaultConfig(PluginConfig& config)
 {
 	config._hide_details      = false;
@@ -49,23 +70,51 @@ void ConfigManager::LoadDefaultConfig(PluginConfig& config)
 	config._button_repository = false;
 	config._hide_if_private   = false;
 	config._hide_idle_status  = false;
+	config._latency_stats     = false;
+	config._arbitrate_instances = true;
 	config._idle_time         = DEF_IDLE_TIME;
+	config._heartbeat_interval = DEF_HEARTBEAT_INTERVAL;
 
 	strncpy(config._details_format, DEF_DETAILS_FORMAT, MAX_FORMAT_BUF - 1);
 	strncpy(config._state_format, DEF_STATE_FORMAT, MAX_FORMAT_BUF - 1);
 	strncpy(config._large_text_format, DEF_LARGE_TEXT_FORMAT, MAX_FORMAT_BUF - 1);
 }
 
-const PluginConfig& ConfigManager::GetConfig() noexcept
+ConfigManager::ConfigManager()
 {
-	AutoUnlock lock(m_mutex);
-	return m_config;
+	// Readers always find a snapshot, the defaults until LoadConfig
+	PluginConfig config{};
+	LoadDefaultConfig(config);
+	Publish(config);
+}
+
+void ConfigManager::Publish(const PluginConfig& config)
+{
+	auto snapshot = std::make_shared<ConfigSnapshot>();
+	snapshot->version = m_version + 1;
+	snapshot->config = config;
+	snapshot->formats.details.Compile(config._details_format);
+	snapshot->formats.state.Compile(config._state_format);
+	snapshot->formats.largeText.Compile(config._large_text_format);
+
+	m_version++;
+	std::atomic_store(&m_current, std::shared_ptr<const ConfigSnapshot>(std::move(snapshot)));
 }
 
 bool ConfigManager::SetConfig(const PluginConfig& newConfig, bool save) noexcept
 {
 	AutoUnlock lock(m_mutex);
-	m_config = newConfig;
+	try
+	{
+		// Saving the options unchanged keeps the current snapshot and the
+		// caches built from it
+		if (newConfig != GetConfig())
+			Publish(newConfig);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
 
 	if (save) return SaveConfig();
 	return true;
@@ -73,15 +122,33 @@ bool ConfigManager::SetConfig(const PluginConfig& newConfig, bool save) noexcept
 
 void ConfigManager::LoadConfig()
 {
+	// The new snapshot is only published once the whole file was read
+	const PluginConfig newConfig = ReadConfigFile(GetConfigFilePath());
+
 	AutoUnlock lock(m_mutex);
+	Publish(newConfig);
+}
 
-	std::wstring configPath = GetConfigFilePath();
+bool ConfigManager::ReloadConfig(const std::wstring& configPath)
+{
+	// Parsed before the lock, an invalid file throws and the current
+	// snapshot stays
+	const PluginConfig newConfig = ReadConfigFile(configPath);
+
+	AutoUnlock lock(m_mutex);
+	if (newConfig == GetConfig())
+		return false;
+	Publish(newConfig);
+	return true;
+}
+
+PluginConfig ConfigManager::ReadConfigFile(const std::wstring& configPath)
+{
+	PluginConfig newConfig{};
+	LoadDefaultConfig(newConfig);
 
 	if (!PathFileExists(configPath.c_str()))
-	{
-		LoadDefaultConfig(m_config);
-		return;
-	}
+		return newConfig;
 
 	std::ifstream stream{ std::filesystem::path(configPath) };
 	if (!stream.is_open())
@@ -93,34 +160,49 @@ void ConfigManager::LoadConfig()
 	if (!config.IsDefined() || config.IsNull())
 		throw std::runtime_error("The configuration file format is invalid: " PLUGIN_CONFIG_FILENAME);
 
-	m_config._hide_details      = config["hideDetails"].as<bool>(false);
-	m_config._elapsed_time      = config["elapsedTime"].as<bool>(true);
-	m_config._enable            = config["enable"].as<bool>(true);
-	m_config._lang_image        = config["langImage"].as<bool>(true);
-	m_config._hide_state        = config["hideState"].as<bool>(false);
-	m_config._client_id         = config["clientId"].as<__int64>(DEF_APPLICATION_ID);
-	m_config._refreshTime       = config["refreshTime"].as<unsigned>(DEF_REFRESH_TIME);
-	m_config._button_repository = config["buttonRepository"].as<bool>(false);
-	m_config._hide_if_private   = config["hideIfPrivate"].as<bool>(false);
-	m_config._hide_idle_status  = config["hideIdleStatus"].as<bool>(false);
-	m_config._idle_time         = config["idleTime"].as<int>(DEF_IDLE_TIME);
-
-	if (m_config._client_id < MIN_CLIENT_ID)
+	newConfig._hide_details      = config["hideDetails"].as<bool>(false);
+	newConfig._elapsed_time      = config["elapsedTime"].as<bool>(true);
+	newConfig._enable            = config["enable"].as<bool>(true);
+	newConfig._lang_image        = config["langImage"].as<bool>(true);
+	newConfig._hide_state        = config["hideState"].as<bool>(false);
+	newConfig._client_id         = config["clientId"].as<__int64>(DEF_APPLICATION_ID);
+	newConfig._refreshTime       = config["refreshTime"].as<unsigned>(DEF_REFRESH_TIME);
+	newConfig._button_repository = config["buttonRepository"].as<bool>(false);
+	newConfig._hide_if_private   = config["hideIfPrivate"].as<bool>(false);
+	newConfig._hide_idle_status  = config["hideIdleStatus"].as<bool>(false);
+	newConfig._idle_time         = config["idleTime"].as<int>(DEF_IDLE_TIME);
+	newConfig._heartbeat_interval = config["heartbeatInterval"].as<int>(DEF_HEARTBEAT_INTERVAL);
+	newConfig._latency_stats     = config["latencyStats"].as<bool>(false);
+	newConfig._arbitrate_instances = config["arbitrateInstances"].as<bool>(true);
+
+	if (newConfig._client_id < MIN_CLIENT_ID)
 	{
-		m_config._client_id = DEF_APPLICATION_ID;
+		newConfig._client_id = DEF_APPLICATION_ID;
 	}
 
-	if (m_config._refreshTime < RPC_UPDATE_TIME)
+	if (newConfig._idle_time <= 0)
 	{
-		m_config._refreshTime = DEF_REFRESH_TIME;
+		newConfig._idle_time = DEF_IDLE_TIME;
 	}
 
-	strncpy(m_config._details_format,
+	if (newConfig._heartbeat_interval < 0)
+	{
+		newConfig._heartbeat_interval = DEF_HEARTBEAT_INTERVAL;
+	}
+
+	if (newConfig._refreshTime < RPC_UPDATE_TIME)
+	{
+		newConfig._refreshTime = DEF_REFRESH_TIME;
+	}
+
+	strncpy(newConfig._details_format,
 		config["detailsFormat"].as<std::string>(DEF_DETAILS_FORMAT).c_str(), MAX_FORMAT_BUF - 1);
-	strncpy(m_config._state_format,
+	strncpy(newConfig._state_format,
 		config["stateFormat"].as<std::string>(DEF_STATE_FORMAT).c_str(), MAX_FORMAT_BUF - 1);
-	strncpy(m_config._large_text_format,
+	strncpy(newConfig._large_text_format,
 		config["largeTextFormat"].as<std::string>(DEF_LARGE_TEXT_FORMAT).c_str(), MAX_FORMAT_BUF - 1);
+
+	return newConfig;
 }
 
 bool ConfigManager::SaveConfig()
@@ -141,22 +223,26 @@ bool ConfigManager::SaveConfig()
 			return false;
 		}
 
+		const PluginConfig& config = GetConfig();
 		YAML::Node node;
 
-		node["hideDetails"]      = m_config._hide_details;
-		node["elapsedTime"]      = m_config._elapsed_time;
-		node["enable"]           = m_config._enable;
-		node["langImage"]        = m_config._lang_image;
-		node["hideState"]        = m_config._hide_state;
-		node["clientId"]         = m_config._client_id;
-		node["detailsFormat"]    = m_config._details_format;
-		node["stateFormat"]      = m_config._state_format;
-		node["largeTextFormat"]  = m_config._large_text_format;
-		node["refreshTime"]      = m_config._refreshTime;
-		node["buttonRepository"] = m_config._button_repository;
-		node["hideIfPrivate"]    = m_config._hide_if_private;
-		node["hideIdleStatus"]   = m_config._hide_idle_status;
-		node["idleTime"]         = m_config._idle_time;
+		node["hideDetails"]      = config._hide_details;
+		node["elapsedTime"]      = config._elapsed_time;
+		node["enable"]           = config._enable;
+		node["langImage"]        = config._lang_image;
+		node["hideState"]        = config._hide_state;
+		node["clientId"]         = config._client_id;
+		node["detailsFormat"]    = config._details_format;
+		node["stateFormat"]      = config._state_format;
+		node["largeTextFormat"]  = config._large_text_format;
+		node["refreshTime"]      = config._refreshTime;
+		node["buttonRepository"] = config._button_repository;
+		node["hideIfPrivate"]    = config._hide_if_private;
+		node["hideIdleStatus"]   = config._hide_idle_status;
+		node["idleTime"]         = config._idle_time;
+		node["heartbeatInterval"] = config._heartbeat_interval;
+		node["latencyStats"]     = config._latency_stats;
+		node["arbitrateInstances"] = config._arbitrate_instances;
 
 		std::ofstream out{ std::filesystem::path(configPath) };
 		out << node;
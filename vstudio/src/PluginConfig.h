@@ -1,4 +1,4 @@
-// Copyright (C) 2022 - 2025 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -16,8 +16,13 @@
 #pragma once
 
 #include <stdlib.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 #include "PluginThread.h"
+#include "PresenceFormat.h"
 
 constexpr size_t MAX_FORMAT_BUF = 128;
 #define PLUGIN_CONFIG_FILENAME "DiscordRPC.yaml"
@@ -37,23 +42,75 @@ struct PluginConfig
 	bool     _button_repository;
 	bool	 _hide_if_private;
 	bool     _hide_idle_status;
+	bool     _latency_stats;
+	bool     _arbitrate_instances;
 	int      _idle_time;
+	int      _heartbeat_interval;
 
 	PluginConfig() = default;
 	PluginConfig(const PluginConfig&) = default;
 	PluginConfig& operator=(const PluginConfig& pg);
+
+	// Compares the values, not the bytes: the padding and whatever follows
+	// the end of each format string are not part of the configuration
+	bool operator==(const PluginConfig& pg) const;
+	bool operator!=(const PluginConfig& pg) const { return !(*this == pg); }
+};
+
+// Format strings of the current PluginConfig, compiled by ConfigManager
+struct PresenceFormats
+{
+	FormatProgram details;
+	FormatProgram state;
+	FormatProgram largeText;
+};
+
+// Immutable state published by ConfigManager, every change publishes a new
+// one. The version grows with each of them, so the caches built from a
+// snapshot know when to rebuild
+struct ConfigSnapshot
+{
+	uint64_t        version;
+	PluginConfig    config;
+	PresenceFormats formats;
 };
 
 class ConfigManager {
 private:
-	PluginConfig m_config;
+	// Loaded and stored with std::atomic_load and std::atomic_store, never
+	// under m_mutex. A replaced snapshot is freed once the last reader
+	// drops it
+	std::shared_ptr<const ConfigSnapshot> m_current;
+	uint64_t m_version = 0;
+	// Serializes the writers
 	BasicMutex m_mutex;
 
+	void Publish(const PluginConfig& config);
 	static void LoadDefaultConfig(PluginConfig& config);
+	// Parses and validates the file, the defaults if it does not exist
+	static PluginConfig ReadConfigFile(const std::wstring& configPath);
 public:
-	const PluginConfig& GetConfig() noexcept;
+	ConfigManager();
+	ConfigManager(const ConfigManager&) = delete;
+	ConfigManager& operator=(const ConfigManager&) = delete;
+
+	// The config and its formats from one snapshot, without m_mutex. The
+	// snapshot stays valid as long as the pointer is kept
+	std::shared_ptr<const ConfigSnapshot> GetSnapshot() const noexcept { return std::atomic_load(&m_current); }
+	// A copy, the snapshot it comes from may be replaced meanwhile
+	PluginConfig GetConfig() const noexcept { return GetSnapshot()->config; }
+	uint64_t GetVersion() const noexcept { return GetSnapshot()->version; }
+
 	bool SetConfig(const PluginConfig& newConfig, bool save = false) noexcept;
 	void LoadConfig();
+	/**
+	 * @brief Reads the file again, from any thread
+	 * @return true if a new snapshot was published, false if the file has
+	 * the current config
+	 * @throws std::exception if the file is invalid, the current config is
+	 * kept
+	 */
+	bool ReloadConfig(const std::wstring& configPath);
 	bool SaveConfig();
 
 	static std::wstring GetConfigFilePath();
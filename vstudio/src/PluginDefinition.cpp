@@ -20,14 +20,17 @@
 #include "PluginConfig.h"
 #include "PluginUtil.h"
 #include "TextEditorInfo.h"
+#include "UpdateScheduler.h"
+#include "ConfigWatcher.h"
+#include "PluginError.h"
+#include "Metrics.hpp"
+#include "NotificationTrace.hpp"
+#include "menuCmdID.h"
 #include <vector>
 #include <mutex>
 #include <string>
 #include <atomic>
-
-#ifdef _DEBUG
-	#include <cstdio>
-#endif // _DEBUG
+#include <cstdio>
 
 #include <tchar.h>
 #include <shlwapi.h>
@@ -65,6 +68,20 @@ RichPresence rpc;
 ConfigManager configManager;
 HINSTANCE hPlugin = nullptr;
 
+// Merges the bursts of editor notifications into one presence rebuild per
+// refresh window. Only accessed from the Notepad++ UI thread
+static UpdateScheduler g_updateScheduler;
+static UINT_PTR g_flushTimer = 0;
+
+// Reloads DiscordRPC.yaml when it is edited while Notepad++ runs
+static ConfigWatcher g_configWatcher;
+
+// Session trace of the "Record session trace" command, see
+// NotificationTrace.hpp. Only accessed from the Notepad++ UI thread
+static TraceWriter g_sessionTrace;
+static std::wstring g_sessionTracePath;
+constexpr size_t TRACE_COMMAND_INDEX = 4;
+
 static std::mutex g_errorMutex;
 static std::string g_errorMessage;
 static std::atomic<bool> g_hasError{false};
@@ -99,6 +116,71 @@ void ShowQueuedErrorIfAny() noexcept
 	}
 }
 
+/**
+ * @brief Applies the config that the watcher reloaded, if any. The snapshot
+ * is already published; the connection, the idle status and the presence
+ * depend on it and are updated on the UI thread
+ */
+static void ApplyReloadedConfigIfAny() noexcept
+{
+	if (g_configWatcher.TakeReloaded())
+		rpc.ApplyConfig();
+}
+
+///////////////////////////////////////////
+
+static void RunScheduledUpdate() noexcept
+{
+	const unsigned reasons = g_updateScheduler.TakeDirty(::GetTickCount64());
+	if (reasons != UPDATE_NONE)
+		rpc.Update(reasons);
+}
+
+static void CancelFlushTimer() noexcept
+{
+	if (g_updateScheduler.IsFlushArmed())
+	{
+		::KillTimer(nullptr, g_flushTimer);
+		g_flushTimer = 0;
+		g_updateScheduler.SetFlushArmed(false);
+	}
+}
+
+static void CALLBACK FlushTimerProc(HWND, UINT, UINT_PTR, DWORD) noexcept
+{
+	CancelFlushTimer();
+	RunScheduledUpdate();
+}
+
+/**
+ * @brief Requests a presence update for the given UpdateReason flags
+ * 
+ * The update runs immediately when the refresh window has expired or the
+ * active buffer changed; otherwise it is merged with the pending one and a
+ * one-shot timer flushes it at the end of the window.
+ */
+static void ScheduleUpdate(unsigned reasons) noexcept
+{
+	g_updateScheduler.SetInterval(configManager.GetSnapshot()->config._refreshTime);
+
+	const ULONGLONG now = ::GetTickCount64();
+	if (g_updateScheduler.Notify(reasons, now))
+	{
+		CancelFlushTimer();
+		RunScheduledUpdate();
+	}
+	else if (!g_updateScheduler.IsFlushArmed())
+	{
+		// Thread timer: no ID is taken from the Notepad++ window
+		g_flushTimer = ::SetTimer(nullptr, 0,
+			static_cast<UINT>(g_updateScheduler.FlushDelay(now)), FlushTimerProc);
+		if (g_flushTimer != 0)
+			g_updateScheduler.SetFlushArmed(true);
+		else
+			RunScheduledUpdate(); // no timer available, do not lose the update
+	}
+}
+
 ///////////////////////////////////////////
 
 extern "C" __declspec(dllexport) void setInfo(NppData notpadPlusData)
@@ -106,11 +188,21 @@ extern "C" __declspec(dllexport) void setInfo(NppData notpadPlusData)
 	nppData = notpadPlusData;
 	
 	configManager.LoadConfig();
+	try
+	{
+		g_configWatcher.Start(ConfigManager::GetConfigFilePath());
+	}
+	catch (const std::exception&)
+	{
+		// Without the watcher the file is only read at startup
+	}
 	
 	setCommand(0, L"Options", OpenPluginOptionsDialog);
 	setCommand(1, nullptr, nullptr);
 	setCommand(2, L"Edit configuration file", OpenConfigurationFile);
-	setCommand(3, L"About", About);
+	setCommand(3, L"Performance report", ShowPerformanceReport);
+	setCommand(TRACE_COMMAND_INDEX, L"Record session trace", RecordSessionTrace);
+	setCommand(5, L"About", About);
 
 	rpc.InitializePresence();
 }
@@ -157,21 +249,32 @@ void About()
  */
 extern "C" __declspec(dllexport) void beNotified(SCNotification *notifyCode)
 {
+	// A queued error waits in a message box and a reloaded config may
+	// restart the connection, neither is part of the typing latency
 	ShowQueuedErrorIfAny();
+	ApplyReloadedConfigIfAny();
 
-	switch (notifyCode->nmhdr.code)
+	// Every notification counts, this is the share of the plugin in the
+	// typing latency
+	ScopedTimer timer(STAGE_NOTIFY);
+
+	const unsigned code = notifyCode->nmhdr.code;
+	if (code == NPPN_SHUTDOWN)
 	{
-	case NPPN_BUFFERACTIVATED:
-	case NPPN_FILERENAMED:
-	case NPPN_LANGCHANGED:
-	case SCN_UPDATEUI:
-		rpc.Update();
-		break;
-	case NPPN_SHUTDOWN:
+		CancelFlushTimer();
+		g_configWatcher.Stop();
 		rpc.Close();
-		break;
-	default:
-		break;
+		SetMessageTrace(nullptr);
+		g_sessionTrace.Close();
+		return;
+	}
+
+	const unsigned reasons = NotificationReasons(code);
+	if (reasons != UPDATE_NONE)
+	{
+		if (g_sessionTrace.IsOpen())
+			g_sessionTrace.Notification(::GetTickCount64(), code);
+		ScheduleUpdate(reasons);
 	}
 }
 
@@ -213,6 +316,94 @@ void OpenConfigurationFile()
 	NppSendMessage(nppData._nppHandle, NPPM_DOOPEN, 0, (LPARAM)configDir.c_str());
 }
 
+/**
+ * @brief Opens a new document with the counters and the latency of every
+ * stage of the presence updates
+ */
+void ShowPerformanceReport()
+{
+	const UpdateSchedulerStats& scheduler = g_updateScheduler.GetStats();
+
+	std::string report = "Discord Rich Presence - performance report\n\n";
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"Updates\n"
+		"  notifications      %llu, %llu merged\n"
+		"  rebuilds           %llu, %llu immediate\n"
+		"\n",
+		(unsigned long long)scheduler.received, (unsigned long long)scheduler.merged,
+		(unsigned long long)scheduler.processed, (unsigned long long)scheduler.immediate);
+	report += buffer;
+
+	try
+	{
+		rpc.WriteReport(report);
+	}
+	catch (const std::exception& e)
+	{
+		ShowErrorMessage(e.what());
+		return;
+	}
+
+	NppSendMessage(nppData._nppHandle, NPPM_MENUCOMMAND, 0, IDM_FILE_NEW);
+	HWND hWndScin = ::GetCurrentScintilla();
+	if (hWndScin)
+		NppSendMessage(hWndScin, SCI_SETTEXT, 0, (LPARAM)report.c_str());
+}
+
+/**
+ * @brief Starts or stops the recording of a session trace
+ * 
+ * The trace holds the options that shape the presence, every notification
+ * that reaches the plugin and the answers of Notepad++ and Scintilla to the
+ * queries of the updates. DiscordRPC_replay runs it again outside of the
+ * editor, see bench/Replay.cpp.
+ */
+void RecordSessionTrace()
+{
+	const int cmdID = funcItem[TRACE_COMMAND_INDEX]._cmdID;
+	if (g_sessionTrace.IsOpen())
+	{
+		SetMessageTrace(nullptr);
+		g_sessionTrace.Close();
+		NppSendMessage(nppData._nppHandle, NPPM_SETMENUITEMCHECK, cmdID, FALSE);
+
+		const std::wstring message = L"The session trace was saved to\n" + g_sessionTracePath;
+		MessageBox(nppData._nppHandle, message.c_str(), _T(TITLE_MBOX_DRPC),
+				   MB_ICONINFORMATION | MB_OK);
+		return;
+	}
+
+	auto path = TextEditorInfo::GetEditorTextPropertyW(NPPM_GETPLUGINSCONFIGDIR);
+	if (path.empty())
+		return;
+	path.append(L"\\DiscordRPC.trace");
+
+	if (!g_sessionTrace.Open(std::filesystem::path(path), ::GetTickCount64()))
+	{
+		ShowErrorMessage(L"The session trace could not be created: " + path);
+		return;
+	}
+	g_sessionTracePath = path;
+
+	const PluginConfig& config = configManager.GetConfig();
+	g_sessionTrace.Config("detailsFormat", config._details_format);
+	g_sessionTrace.Config("stateFormat", config._state_format);
+	g_sessionTrace.Config("largeTextFormat", config._large_text_format);
+	g_sessionTrace.Config("hideDetails", config._hide_details ? "true" : "false");
+	g_sessionTrace.Config("hideState", config._hide_state ? "true" : "false");
+	g_sessionTrace.Config("langImage", config._lang_image ? "true" : "false");
+	g_sessionTrace.Config("hideIfPrivate", config._hide_if_private ? "true" : "false");
+	g_sessionTrace.Config("buttonRepository", config._button_repository ? "true" : "false");
+	g_sessionTrace.Config("hideIdleStatus", config._hide_idle_status ? "true" : "false");
+	g_sessionTrace.Config("refreshTime", std::to_string(config._refreshTime));
+	g_sessionTrace.Config("idleTime", std::to_string(config._idle_time));
+	g_sessionTrace.Config("heartbeatInterval", std::to_string(config._heartbeat_interval));
+
+	SetMessageTrace(&g_sessionTrace);
+	NppSendMessage(nppData._nppHandle, NPPM_SETMENUITEMCHECK, cmdID, TRUE);
+}
+
 ////////////////////////////////////////////
 
 BOOL APIENTRY DllMain(HANDLE hModule, DWORD reasonForCall, LPVOID)
@@ -250,3 +441,4 @@ BOOL APIENTRY DllMain(HANDLE hModule, DWORD reasonForCall, LPVOID)
 
 	return TRUE;
 }
+
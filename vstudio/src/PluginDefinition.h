@@ -26,13 +26,15 @@ void QueueErrorMessage(const std::string &msg) noexcept;
 void ShowQueuedErrorIfAny() noexcept;
 
 const TCHAR NPP_PLUGIN_NAME[] = TEXT("Discord Rich Presence");
-const int nbFunc = 4;
+const int nbFunc = 6;
 
 bool setCommand(size_t index, const TCHAR *cmdName, PFUNCPLUGINCMD pFunc, 
 				ShortcutKey *sk = NULL, bool check0nInit = false);
 
 void OpenPluginOptionsDialog();
 void OpenConfigurationFile();
+void ShowPerformanceReport();
+void RecordSessionTrace();
 void About();
 
 
@@ -30,9 +30,7 @@
 #include <chrono>
 
 #include "PluginError.h"
-
-static constexpr DWORD THREAD_UPDATE_INTERVAL_MS = 1000;
-static constexpr const char *NPP_NAME = "Notepad++";
+#include "Metrics.hpp"
 
 extern ConfigManager configManager;
 extern NppData nppData;
@@ -48,212 +46,147 @@ static void DiscordErrorCallback(const std::string &message) noexcept
 
 void RichPresence::InitializePresence()
 {
-	if (!_callbacks && configManager.GetConfig()._enable)
+	const PluginConfig& config = configManager.GetConfig();
+	Metrics::SetEnabled(config._latency_stats);
+	if (config._enable)
 	{
-		try
-		{
-			_callbacks = new BasicThread(RichPresence::CallBacks, this);
-			_idleTimer = new BasicThread(RichPresence::IdlingTimer, this);
-		}
-		catch (const std::exception &exception)
-		{
-			if (_callbacks != nullptr)
-				Close();
-			throw exception;
-		}
+		// With several Notepad++ processes only the one the user worked in
+		// last talks to Discord, the others wait without a connection
+		_drp.SetArbitration(config._arbitrate_instances);
+
+		// Connection errors are only logged, the errors Discord answers a
+		// presence with are shown on the next notification of the editor
+		if (!_drp.Start(config._client_id, DiscordErrorCallback, QueueErrorMessage))
+			throw std::runtime_error("The Discord connection thread could not be started");
+		_clientId = config._client_id;
+		_arbitrate = config._arbitrate_instances;
+
+		// Resolved presences go straight to the connection thread
+		if (!_resolver.Start([this](const Presence& presence, bool isIdling) {
+				_drp.PostPresence(presence, isIdling);
+			}))
+			throw std::runtime_error("The presence resolver thread could not be started");
+
+		// The connection thread keeps the idle deadline with its other
+		// timers, there is no thread polling for it
+		Presence idle;
+		idle.details = "Idling";
+		idle.largeText = NPP_NAME;
+		idle.largeImage = NPP_IDLEIMAGE;
+		_drp.SetIdleStatus(config._hide_idle_status ? nullptr : &idle, std::chrono::seconds(config._idle_time));
+		_drp.SetHeartbeatInterval(std::chrono::seconds(config._heartbeat_interval));
 	}
 }
 
-void RichPresence::Update() noexcept
+void RichPresence::ApplyConfig() noexcept
 {
-	_editorInfo.LoadEditorStatus();
-
-	const PluginConfig config = configManager.GetConfig();
-
-	_p.enableButtonRepository = config._button_repository;
-	_p.details = _p.state = _p.repositoryUrl = "";
-
-	// If the current file is private and the option to hide the presence
-	// when it is private is enabled, the presence will be closed
-	if (config._hide_if_private && !_editorInfo.IsFileInfoEmpty() && _editorInfo.IsCurrentFilePrivate())
+	const PluginConfig& config = configManager.GetConfig();
+	if (!config._enable)
 	{
-		_p.details = "Private File";
-		_p.smallText = "";
-		_p.largeText = NPP_NAME;
-		_p.largeImage = NPP_DEFAULTIMAGE;
-
-		_pTemp = _p;
-		if (_drp.IsConnected())
-		{
-			_drp.SetPresence(_p, _editorInfo.IsTextEditorIdling(),
-				DiscordErrorCallback);
-		}
+		Close();
 		return;
 	}
 
-	UpdateAssets();
-	if (config._button_repository)
-		_p.repositoryUrl = _editorInfo.GetCurrentRepositoryUrl();
-	if (!_editorInfo.IsFileInfoEmpty())
+	try
 	{
-		if (!config._hide_details)
-			_editorInfo.WriteFormat(_p.details, config._details_format);
-		if (!config._hide_state)
-			_editorInfo.WriteFormat(_p.state, config._state_format);
+		// Start keeps a running connection, the old ID or arbitration has to
+		// close first
+		if (config._client_id != _clientId || config._arbitrate_instances != _arbitrate)
+			Close();
+		InitializePresence();
 	}
-
-	_pTemp = _p;
-	if (_drp.IsConnected())
+	catch (const std::exception& e)
 	{
-		_drp.SetPresence(_p, _editorInfo.IsTextEditorIdling(),
-			DiscordErrorCallback);
+		QueueErrorMessage(e.what());
+		return;
 	}
+	Update();
 }
 
-static void SafeStopAndDelete(BasicThread *&thread) noexcept
+void RichPresence::Update(unsigned reasons) noexcept
 {
-	if (thread)
+	ScopedTimer timer(STAGE_UPDATE);
+
+	// One snapshot for the whole update, the config and its formats always
+	// match even if the options are saved meanwhile
+	const std::shared_ptr<const ConfigSnapshot> snapshot = configManager.GetSnapshot();
+	const PluginConfig& config = snapshot->config;
+	const PresenceFormats& formats = snapshot->formats;
+
+	PresenceOptions options;
+	options.formatOwner = snapshot;
+	options.details = &formats.details;
+	options.state = &formats.state;
+	options.largeText = &formats.largeText;
+	options.hideDetails = config._hide_details;
+	options.hideState = config._hide_state;
+	options.langImage = config._lang_image;
+	options.hideIfPrivate = config._hide_if_private;
+	options.buttonRepository = config._button_repository;
+	options.hideIdleStatus = config._hide_idle_status;
+
+	// Only the properties that the shown formats and the enabled options use
+	// are requested from the editor. They only change with the config
+	if (_queryVersion != snapshot->version)
 	{
-		thread->Stop();
-		thread->Wait();
-		delete thread;
-		thread = nullptr;
+		_query = MakeEditorQuery(options);
+		_queryVersion = snapshot->version;
 	}
+	_editorInfo.LoadEditorStatus(reasons, _query);
+
+	// Only the values Notepad++ and Scintilla answer from memory are read
+	// here. The workspace, the repository URL and the privacy of the file
+	// need the filesystem, the resolver thread finds them and publishes the
+	// presence, so the editor never waits for the disk or for Discord
+	_editorInfo.CaptureSnapshot(_editorSnapshot);
+	ApplyPresenceOptions(options, _query, _editorSnapshot);
+	_resolver.Post(_editorSnapshot);
 }
 
 void RichPresence::Close() noexcept
 {
-	SafeStopAndDelete(_callbacks);
-	SafeStopAndDelete(_idleTimer);
-
-	_drp.Close(DiscordErrorCallback);
+	_resolver.Stop();
+	_drp.Close();
 }
 
-void RichPresence::UpdateAssets() noexcept
+void RichPresence::WriteReport(std::string& out) const
 {
-	_p.smallText = _p.smallImage =
-		_p.largeText = _p.largeImage = "";
-
-	bool isFileEmpty = _editorInfo.IsFileInfoEmpty();
-	if (!configManager.GetConfig()._lang_image || isFileEmpty)
-	{
-		_p.largeImage = NPP_DEFAULTIMAGE;
-		_p.largeText = NPP_NAME;
-	}
+	const DiscordIPCStats ipc = _drp.GetStats();
+	const PresenceResolverStats resolver = _resolver.GetStats();
+
+	char buffer[768];
+	snprintf(buffer, sizeof(buffer),
+		"Discord\n"
+		"  connected          %s%s\n"
+		"  connections        %llu\n"
+		"  errors             %llu\n"
+		"  frames sent        %llu (%llu bytes)\n"
+		"  frames received    %llu (%llu bytes)\n"
+		"  activities sent    %llu, %llu unchanged\n"
+		"  pings sent         %llu, %llu pongs received\n"
+		"  pings of Discord   %llu answered\n"
+		"  handovers          %llu\n"
+		"\n"
+		"Resolver\n"
+		"  snapshots posted   %llu, %llu replaced before resolved\n"
+		"  presences resolved %llu\n"
+		"  workspace loads    %llu\n"
+		"\n",
+		_drp.IsConnected() ? "yes" : "no",
+		_drp.IsStandby() ? " (another Notepad++ holds the presence)" : "",
+		(unsigned long long)ipc.connections, (unsigned long long)ipc.errors,
+		(unsigned long long)ipc.framesSent, (unsigned long long)ipc.bytesSent,
+		(unsigned long long)ipc.framesReceived, (unsigned long long)ipc.bytesReceived,
+		(unsigned long long)ipc.activitiesSent, (unsigned long long)ipc.activitiesSkipped,
+		(unsigned long long)ipc.pingsSent, (unsigned long long)ipc.pongsReceived,
+		(unsigned long long)ipc.pingsAnswered,
+		(unsigned long long)ipc.handovers,
+		(unsigned long long)resolver.posted, (unsigned long long)resolver.dropped,
+		(unsigned long long)resolver.resolved, (unsigned long long)resolver.workspaceLoads);
+	out += buffer;
+
+	if (Metrics::Enabled())
+		Metrics::WriteReport(out);
 	else
-	{
-		_p.largeImage = _editorInfo.GetLanguageInfo()._large_image;
-		_editorInfo.WriteFormat(_p.largeText, configManager.GetConfig()._large_text_format);
-		if (_p.largeImage != NPP_DEFAULTIMAGE)
-		{
-			_p.smallImage = NPP_DEFAULTIMAGE;
-			_p.smallText = NPP_NAME;
-		}
-	}
-}
-
-void RichPresence::Connect(volatile bool *keepRunning) noexcept
-{
-	while (keepRunning && *keepRunning)
-	{
-		if (_drp.Connect(configManager.GetConfig()._client_id,
-				DiscordErrorCallback))
-			break;
-		BasicThread::Sleep(keepRunning, RPC_TIME_RECONNECTION);
-	}
-}
-
-// Static thread callback
-
-void RichPresence::CallBacks(void *data, volatile bool *keepRunning) noexcept
-{
-	try
-	{
-		RichPresence *rpc = reinterpret_cast<RichPresence *>(data);
-		DiscordRichPresence &drp = rpc->_drp;
-		// Determines whether a new start timestamp should be generated for Discord presence.
-		// Set to false after the first connection to maintain persistence during reconnections
-		bool shouldInitializeTime = true;
-
-		while (*keepRunning)
-		{
-			rpc->Connect(keepRunning);
-			if (!(*keepRunning))
-				return;
-
-			Presence pTemp = rpc->_pTemp;
-
-			if (shouldInitializeTime)
-			{
-				AutoUnlock lock(rpc->_mutex);
-				// Set the start time to the current time
-				rpc->_p.startTime = std::chrono::duration_cast<std::chrono::seconds>(
-										std::chrono::system_clock::now().time_since_epoch())
-										.count();
-				pTemp.startTime = rpc->_p.startTime;
-				shouldInitializeTime = false;
-			}
-
-			drp.SetPresence(pTemp, false, DiscordErrorCallback);
-
-			while (*keepRunning)
-			{
-				drp.Update(DiscordErrorCallback);
-				if (!*keepRunning || !drp.IsConnected())
-					break;
-				BasicThread::Sleep(keepRunning, RPC_UPDATE_TIME);
-			}
-		}
-	}
-	catch (const std::exception &e)
-	{
-		QueueErrorMessage(e.what());
-		return;
-	}
-}
-
-void RichPresence::IdlingTimer(void *data, volatile bool *keepRunning) noexcept
-{
-	try
-	{
-		RichPresence *rpc = reinterpret_cast<RichPresence *>(data);
-
-		bool isIdling = false;
-
-		while (*keepRunning)
-		{
-			BasicThread::Sleep(keepRunning, THREAD_UPDATE_INTERVAL_MS);
-			if (configManager.GetConfig()._hide_idle_status)
-				continue;
-
-			if (rpc->_drp.LastUpdateTimeElapsed(configManager.GetConfig()._idle_time))
-			{
-				if (isIdling)
-					continue;
-				isIdling = true;
-
-				Presence p;
-				p.details = "Idling";
-				p.largeText = NPP_NAME;
-				p.largeImage = NPP_IDLEIMAGE;
-
-				{
-					AutoUnlock lock(rpc->_mutex);
-					p.startTime = rpc->_p.startTime;
-				}
-
-				rpc->_drp.SetIdleStatus(&p, DiscordErrorCallback);
-			}
-			else if (isIdling)
-			{
-				isIdling = false;
-				rpc->_drp.SetIdleStatus(nullptr, DiscordErrorCallback);
-			}
-		}
-	}
-	catch (const std::exception &e)
-	{
-		QueueErrorMessage(e.what());
-		return;
-	}
+		out += "Latency recording is disabled, set latencyStats: true in " PLUGIN_CONFIG_FILENAME "\n";
 }
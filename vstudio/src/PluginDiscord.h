@@ -1,4 +1,4 @@
-// Copyright (C) 2022 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,6 +22,7 @@
 #include "PluginConfig.h"
 #include "PluginUtil.h"
 #include "TextEditorInfo.h"
+#include "UpdateScheduler.h"
 #include "DiscordRichPresence.hpp"
 
 class RichPresence
@@ -31,56 +32,27 @@ public:
 	RichPresence(const RichPresence&) = delete;
 
 	void InitializePresence();
-	void Update() noexcept;
+	// Applies a new config: the connection only starts again for a new
+	// application ID, the presence is rebuilt
+	void ApplyConfig() noexcept;
+	void Update(unsigned reasons = UPDATE_ALL) noexcept;
 	void Close() noexcept;
+	// Appends the counters of the connection and the resolver and the
+	// latency of every stage
+	void WriteReport(std::string& out) const;
 	
 private:
-	class PresenceTemp
-	{
-	public:
-		PresenceTemp() = default;
-		PresenceTemp(const PresenceTemp&) = delete;
-		PresenceTemp& operator=(const PresenceTemp&) = delete;
-
-		void operator=(const Presence& p)
-		{
-			AutoUnlock lock(mutex);
-			m_pTemp = p;
-		}
-		
-		operator Presence()
-		{
-			AutoUnlock lock(mutex);
-			return m_pTemp;
-		}
-	private:
-		Presence m_pTemp;
-		BasicMutex mutex;
-	};
-
-	
 	DiscordRichPresence _drp;
-	Presence            _p;
+	__int64             _clientId = 0;
+	bool                _arbitrate = false;
+	// Declared after _drp, it is stopped before the connection closes
+	PresenceResolver    _resolver;
 
-	// Allows you to save the presence status for use in a reconnection or
-	// other factor that momentarily interrupts the presence update. It is
-	// stored in a temporary variable.
-	PresenceTemp        _pTemp;
-	
 	TextEditorInfo		_editorInfo;
-
-	// Thread that calls the Discord callbacks every few seconds
-	BasicThread*        _callbacks  = nullptr;
-	// Thread that increments the idle time counter every second
-	BasicThread*        _idleTimer  = nullptr;
-
-	// Avoid multithreaded access to fields of the Presence _p object,
-	// such as @field startTime.
-	BasicMutex          _mutex;
-
-	void UpdateAssets() noexcept;
-	void Connect(volatile bool* keepRunning = nullptr) noexcept;
-
-	static void CallBacks(void* data, volatile bool* keepRunning = nullptr) noexcept;
-	static void IdlingTimer(void* data, volatile bool* keepRunning = nullptr) noexcept;
+	// Reused for every update, Post copies it into the resolver
+	EditorSnapshot      _editorSnapshot;
+	// Properties the current config needs, built again when its version
+	// changes
+	EditorQuery         _query;
+	uint64_t            _queryVersion = 0;
 };
@@ -1,4 +1,4 @@
-// Copyright (C) 2022 - 2023 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -271,6 +271,9 @@ static bool ProcessCommand(HWND hDlg)
 	const PluginConfig config = configManager.GetConfig();
 
 	copy._idle_time = config._idle_time;
+	copy._heartbeat_interval = config._heartbeat_interval;
+	copy._latency_stats = config._latency_stats;
+	copy._arbitrate_instances = config._arbitrate_instances;
 	copy._refreshTime  = config._refreshTime;
 
 	// The new formats are obtained but first they are validated
@@ -281,23 +284,13 @@ static bool ProcessCommand(HWND hDlg)
 		return false;
 	}
 
-	if (memcmp(&copy, &config, sizeof(PluginConfig)) != 0)
+	if (copy != config)
 	{
 		if (!configManager.SetConfig(copy, true))
 			return false;
 
-		if (!copy._enable)
-			rpc.Close();
-		else
-		{
-			if (client_id != config._client_id)
-			{
-				MessageBox(hDlg, _T("For the new application ID to work, you must close and reopen Notepad++"), NULL, 0);
-			}
-
-			rpc.InitializePresence();
-			rpc.Update();
-		}
+		// A new application ID reconnects at once
+		rpc.ApplyConfig();
 	}
 	return true;
 }
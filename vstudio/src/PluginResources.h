@@ -34,6 +34,7 @@
 #define RPC_TIME_RECONNECTION			2000
 #define DEF_REFRESH_TIME                1000
 #define DEF_IDLE_TIME                   300 // seconds
+#define DEF_HEARTBEAT_INTERVAL          15  // seconds
 
 #define MIN_CLIENT_ID                   ((__int64)1E16)
 #define MIN_LENGTH_CLIENT_ID            17
@@ -1,4 +1,4 @@
-// Copyright (C) 2022 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,12 +21,56 @@
 
 ////////////////////////////////////////////////////////////////////
 
-typedef void(*BASIC_THREAD_ROUTINE)(void*, volatile bool*);
+/**
+ * Stop request of a thread, backed by a manual reset event so a sleeping
+ * thread blocks until the deadline or the request without polling.
+ */
+class StopToken {
+public:
+	StopToken() : event(::CreateEvent(NULL, TRUE, FALSE, NULL)) {
+		if (!event) {
+			throw std::runtime_error("CreateEvent() returns NULL");
+		}
+	}
+
+	~StopToken() {
+		::CloseHandle(event);
+	}
+
+	StopToken(const StopToken&) = delete;
+	StopToken& operator=(const StopToken&) = delete;
+
+	void RequestStop() {
+		::SetEvent(event);
+	}
+
+	bool StopRequested() const {
+		return ::WaitForSingleObject(event, 0) == WAIT_OBJECT_0;
+	}
+
+	/**
+	 * @brief Blocks until the time passes or the stop is requested
+	 * @return false if the stop was requested
+	 */
+	bool Sleep(DWORD milliseconds) const {
+		return ::WaitForSingleObject(event, milliseconds) == WAIT_TIMEOUT;
+	}
+
+	// For waits on other handles together with the stop request
+	HANDLE GetHandle() const {
+		return event;
+	}
+
+private:
+	HANDLE event;
+};
+
+typedef void(*BASIC_THREAD_ROUTINE)(void*, const StopToken&);
 
 class BasicThread {
 public:
 	BasicThread(BASIC_THREAD_ROUTINE run, void* data = nullptr)
-		: data(data), keepRunning(new volatile bool(true)), func(run)
+		: data(data), func(run)
 	{
 		handle = ::CreateThread(nullptr, 0, (LPTHREAD_START_ROUTINE)Run, this, 0, nullptr);
 		if (!handle) {
@@ -36,13 +80,11 @@ public:
 
 	~BasicThread() {
 		Terminate();
-		delete keepRunning;
 	}
 
-	void Terminate() const {
-		DWORD exitCode;
-		if (!::GetExitCodeThread(handle, &exitCode)) {
-			*keepRunning = false;
+	void Terminate() {
+		if (IsRunning()) {
+			stopToken.RequestStop();
 			::WaitForSingleObject(handle, INFINITE);
 		}
 
@@ -50,53 +92,39 @@ public:
 	}
 
 	void Wait(DWORD milliseconds = INFINITE) const {
-		DWORD exitCode;
-		if (!::GetExitCodeThread(handle, &exitCode)) {
+		if (IsRunning()) {
 			::WaitForSingleObject(handle, milliseconds);
 		}
 	}
 
-	void Stop() {
-		*keepRunning = false;
+	bool IsRunning() const {
+		DWORD exitCode;
+		return ::GetExitCodeThread(handle, &exitCode) && exitCode == STILL_ACTIVE;
 	}
 
-	static void Sleep(volatile bool* keepRunning, DWORD totalMilliseconds) {
-		if (!keepRunning || !(*keepRunning) || totalMilliseconds == 0)
-			return;
-
-		HANDLE timer = CreateWaitableTimer(NULL, TRUE, NULL);
-		if (!timer) return;
-
-		LARGE_INTEGER li{};
-		li.QuadPart = -static_cast<LONGLONG>(totalMilliseconds) * 10000;
-
-		if (!SetWaitableTimer(timer, &li, 0, NULL, NULL, FALSE)) {
-			CloseHandle(timer);
-			return;
-		}
-
-		const DWORD checkInterval = 10;
-		DWORD waited = 0;
-
-		while (waited < totalMilliseconds && *keepRunning) {
-			DWORD result = WaitForSingleObject(timer, checkInterval);
-			if (result == WAIT_OBJECT_0) break;
-			waited += checkInterval;
-		}
+	void Stop() {
+		stopToken.RequestStop();
+	}
 
-		CloseHandle(timer);
+	/**
+	 * @brief Sleeps until the time passes or the thread is stopped
+	 * @return false if the thread was stopped
+	 */
+	static bool Sleep(const StopToken& stopToken, DWORD milliseconds) {
+		return stopToken.Sleep(milliseconds);
 	}
 
 
 private:
 	static DWORD CALLBACK Run(void* param) {
 		BasicThread* thread = static_cast<BasicThread*>(param);
-		thread->func(thread->data, thread->keepRunning);
+		thread->func(thread->data, thread->stopToken);
 		return 0;
 	}
 
 	void* data;
-	volatile bool* keepRunning;
+	// Created before the thread starts, which only sees it as const
+	StopToken stopToken;
 	BASIC_THREAD_ROUTINE func;
 	HANDLE handle;
 };
@@ -1,4 +1,4 @@
-// Copyright (C) 2022 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -15,6 +15,7 @@
 
 #include "PluginUtil.h"
 #include "PluginInterface.h"
+#include "NotificationTrace.hpp"
 
 #ifdef _DEBUG
 #include <stdio.h>
@@ -22,11 +23,15 @@
 
 #include <assert.h>
 #include <stdexcept>
+#include <string>
 
 extern HINSTANCE hPlugin;
 extern NppData   nppData;
 
 
+// Session trace being recorded, only used by the UI thread
+static TraceWriter* g_messageTrace = nullptr;
+
 // Exclusive use buffer of the GetRCString function to save a string resource
 static TCHAR string_buffer[512];
 
@@ -37,6 +42,47 @@ LPTSTR GetRCString(unsigned ids)
 	return string_buffer;
 }
 
+/**
+ * @brief Records the answer of a message that the presence depends on, the
+ * rest of the messages are not part of the trace
+ */
+static void RecordAnswer(UINT Msg, LPARAM lParam, LRESULT result)
+{
+	switch (Msg)
+	{
+	case NPPM_GETFILENAME:
+	case NPPM_GETEXTPART:
+	case NPPM_GETCURRENTDIRECTORY:
+		// A FALSE answer only asks for a larger buffer
+		if (result)
+		{
+			const wchar_t* text = reinterpret_cast<const wchar_t*>(lParam);
+			std::string utf8;
+			const int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+			if (size > 0)
+			{
+				utf8.resize(size - 1);
+				WideCharToMultiByte(CP_UTF8, 0, text, -1, utf8.data(), size, nullptr, nullptr);
+			}
+			g_messageTrace->Text(Msg, utf8);
+		}
+		break;
+	case NPPM_GETCURRENTLANGTYPE:
+	case NPPM_GETCURRENTSCINTILLA:
+		g_messageTrace->Answer(Msg, *reinterpret_cast<const int*>(lParam));
+		break;
+	case NPPM_GETCURRENTLINE:
+	case NPPM_GETCURRENTCOLUMN:
+	case SCI_GETLENGTH:
+	case SCI_GETLINECOUNT:
+	case SCI_GETCURRENTPOS:
+		g_messageTrace->Answer(Msg, static_cast<int64_t>(result));
+		break;
+	default:
+		break;
+	}
+}
+
 HWND GetCurrentScintilla()
 {
 	int which = -1;
@@ -50,5 +96,13 @@ LRESULT NppSendMessage(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
 {
 	if (GetWindowThreadProcessId(hWnd, nullptr) != GetCurrentThreadId())
 		throw std::runtime_error("NppSendMessage cannot be called from a background thread.");
-	return ::SendMessage(hWnd, Msg, wParam, lParam);
+	const LRESULT result = ::SendMessage(hWnd, Msg, wParam, lParam);
+	if (g_messageTrace)
+		RecordAnswer(Msg, lParam, result);
+	return result;
+}
+
+void SetMessageTrace(TraceWriter* trace)
+{
+	g_messageTrace = trace;
 }
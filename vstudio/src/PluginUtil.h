@@ -1,4 +1,4 @@
-// Copyright (C) 2022 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -19,6 +19,11 @@
 
 #define WM_NPP_SENDMESSAGE_SYNC (WM_USER + 1001)
 
+class TraceWriter;
+
 LPTSTR GetRCString(unsigned ids);
 HWND GetCurrentScintilla();
 LRESULT NppSendMessage(HWND hWnd, UINT Msg, WPARAM wParam = 0, LPARAM lParam = 0);
+// While a trace is set, NppSendMessage records the answers of the editor
+// queries in it. Null stops the recording
+void SetMessageTrace(TraceWriter* trace);
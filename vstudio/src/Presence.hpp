@@ -0,0 +1,127 @@
+// Copyright (C) 2025 - 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Rich presence shown by Discord.
+ *
+ * Every text field carries a revision. SetText gives a field a new
+ * process-wide unique revision only when its value changes, so two
+ * presences with the same non-zero revision of a field hold the same value
+ * and the field does not need to be compared or serialized again. A field
+ * written directly keeps revision 0 and is compared by value; a producer
+ * that uses SetText must not write the field directly.
+ */
+struct Presence
+{
+    enum Field : uint8_t
+    {
+        FIELD_STATE,
+        FIELD_DETAILS,
+        FIELD_LARGE_IMAGE,
+        FIELD_LARGE_TEXT,
+        FIELD_SMALL_IMAGE,
+        FIELD_SMALL_TEXT,
+        FIELD_REPOSITORY_URL,
+        FIELD_COUNT
+    };
+
+    std::string state;
+    std::string details;
+    std::string largeImage;
+    std::string largeText;
+    std::string smallImage;
+    std::string smallText;
+    std::string repositoryUrl;
+    int64_t startTime = 0;
+    int64_t endTime = 0;
+    bool enableButtonRepository = false;
+
+    uint64_t revisions[FIELD_COUNT] = {};
+
+    const std::string &Text(Field field) const noexcept
+    {
+        return const_cast<Presence *>(this)->Text(field);
+    }
+
+    std::string &Text(Field field) noexcept
+    {
+        switch (field)
+        {
+        case FIELD_STATE:       return state;
+        case FIELD_DETAILS:     return details;
+        case FIELD_LARGE_IMAGE: return largeImage;
+        case FIELD_LARGE_TEXT:  return largeText;
+        case FIELD_SMALL_IMAGE: return smallImage;
+        case FIELD_SMALL_TEXT:  return smallText;
+        default:                return repositoryUrl;
+        }
+    }
+
+    /**
+     * @brief Assigns a text field, its revision only changes if the value
+     * does
+     * @return true if the value changed
+     */
+    bool SetText(Field field, std::string_view value)
+    {
+        std::string &text = Text(field);
+        if (revisions[field] != 0 && text == value)
+            return false;
+        text.assign(value.data(), value.size());
+        revisions[field] = NextRevision();
+        return true;
+    }
+
+    /**
+     * @brief Checks if a field holds the same value in both presences,
+     * without comparing the strings when the revisions tell it
+     */
+    bool SameText(const Presence &other, Field field) const noexcept
+    {
+        if (revisions[field] != 0 && revisions[field] == other.revisions[field])
+            return true;
+        return Text(field) == other.Text(field);
+    }
+
+    bool SameTexts(const Presence &other) const noexcept
+    {
+        for (int field = 0; field < FIELD_COUNT; field++)
+            if (!SameText(other, static_cast<Field>(field)))
+                return false;
+        return true;
+    }
+
+    bool compare(const Presence &other) const
+    {
+        return SameTexts(other) &&
+               startTime == other.startTime &&
+               endTime == other.endTime &&
+               enableButtonRepository == other.enableButtonRepository;
+    }
+
+private:
+    static uint64_t NextRevision() noexcept
+    {
+        static std::atomic<uint64_t> counter{ 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+};
@@ -0,0 +1,55 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "PresenceFormat.h"
+
+#include <cstring>
+
+void FormatProgram::Compile(const char* format)
+{
+	_literals.clear();
+	_code.clear();
+	_tokenMask = 0;
+
+	if (format == nullptr)
+		return;
+
+	for (size_t i = 0; format[i] != '\0';)
+	{
+		if (format[i] == '%' && format[i + 1] == '(')
+		{
+			size_t k = 0;
+			for (; k < TOKEN_COUNT; k++)
+			{
+				const size_t length = std::strlen(FORMAT_TOKENS[k]);
+				if (std::strncmp(format + i, FORMAT_TOKENS[k], length) == 0)
+				{
+					_code.push_back({ static_cast<uint8_t>(k), 0, 0 });
+					_tokenMask |= 1u << k;
+					i += length;
+					break;
+				}
+			}
+			if (k < TOKEN_COUNT)
+				continue;
+		}
+
+		// Consecutive characters are merged into one literal span
+		if (_code.empty() || _code.back().token != LITERAL)
+			_code.push_back({ LITERAL, static_cast<uint16_t>(_literals.size()), 0 });
+		_literals.push_back(format[i++]);
+		_code.back().length++;
+	}
+}
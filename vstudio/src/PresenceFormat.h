@@ -0,0 +1,118 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Properties of the editor that can be used in the presence formats. The
+ * order is the one of FORMAT_TOKENS.
+ */
+enum FormatToken : uint8_t
+{
+	TOKEN_FILE,
+	TOKEN_EXTENSION,
+	TOKEN_LINE,
+	TOKEN_COLUMN,
+	TOKEN_SIZE,
+	TOKEN_LINE_COUNT,
+	TOKEN_LANG,       // lower case name
+	TOKEN_LANG_TITLE, // name as shown by Notepad++
+	TOKEN_LANG_UPPER, // upper case name
+	TOKEN_POSITION,
+	TOKEN_WORKSPACE,
+	TOKEN_COUNT
+};
+
+constexpr const char* FORMAT_TOKENS[TOKEN_COUNT] =
+{
+	"%(file)", "%(extension)", "%(line)", "%(column)",
+	"%(size)", "%(line_count)", "%(lang)", "%(Lang)",
+	"%(LANG)", "%(position)", "%(workspace)"
+};
+
+/**
+ * A presence format string compiled into a list of literal spans and token
+ * references, so that rendering it is a single pass without any search.
+ * Formats are compiled when the configuration changes.
+ */
+class FormatProgram
+{
+public:
+	// Same limit as the 128 byte buffer the formats were written to
+	static constexpr size_t MAX_OUTPUT = 126;
+
+	FormatProgram() = default;
+	explicit FormatProgram(const char* format) { Compile(format); }
+
+	/**
+	 * @brief Replaces the program with the one of the format
+	 * @details Text that is not a known token, including an unknown
+	 * "%(name)", is copied as is
+	 */
+	void Compile(const char* format);
+
+	/**
+	 * @brief Writes the format with the values of the tokens
+	 * @param source Callable that receives a FormatToken and returns the
+	 * value as something convertible to std::string_view
+	 */
+	template <class Source>
+	void Render(std::string& out, Source&& source) const;
+
+	/**
+	 * @brief Bit (1 << token) set for each FormatToken used by the format
+	 */
+	unsigned GetTokenMask() const noexcept { return _tokenMask; }
+	bool Empty() const noexcept { return _code.empty(); }
+
+private:
+	static constexpr uint8_t LITERAL = TOKEN_COUNT;
+
+	struct Instruction
+	{
+		uint8_t  token;  // FormatToken, or LITERAL
+		uint16_t offset; // LITERAL: span in _literals
+		uint16_t length;
+	};
+
+	std::string _literals;
+	std::vector<Instruction> _code;
+	unsigned _tokenMask = 0;
+};
+
+template <class Source>
+void FormatProgram::Render(std::string& out, Source&& source) const
+{
+	out.clear();
+	for (const Instruction& in : _code)
+	{
+		std::string_view piece = in.token == LITERAL ?
+			std::string_view(_literals).substr(in.offset, in.length) :
+			std::string_view(source(static_cast<FormatToken>(in.token)));
+
+		const size_t room = MAX_OUTPUT - out.size();
+		if (piece.size() >= room)
+		{
+			out.append(piece.data(), room);
+			break;
+		}
+		out.append(piece.data(), piece.size());
+	}
+}
@@ -0,0 +1,239 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "PresenceResolver.hpp"
+#include "LanguageInfo.h"
+#include "Metrics.hpp"
+
+#include <exception>
+#include <filesystem>
+
+PresenceResolver::~PresenceResolver()
+{
+    Stop();
+}
+
+bool PresenceResolver::Start(PublishCallback publish) noexcept
+{
+    if (_worker.joinable())
+        return true;
+
+    _publish = std::move(publish);
+    _stopping = false;
+    try
+    {
+        _worker = std::thread(&PresenceResolver::Run, this);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return true;
+}
+
+void PresenceResolver::Stop() noexcept
+{
+    if (!_worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_one();
+    _worker.join();
+}
+
+void PresenceResolver::Post(const EditorSnapshot& snapshot) noexcept
+{
+    try
+    {
+        if (_slot.Publish(snapshot))
+            _counters.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return;
+    }
+    _counters.posted.fetch_add(1, std::memory_order_relaxed);
+
+    // Taking the mutex orders the publication before the wait predicate of
+    // the worker, so the wake cannot be lost
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+    }
+    _wake.notify_one();
+}
+
+void PresenceResolver::Run() noexcept
+{
+    for (;;)
+    {
+        EditorSnapshot* snapshot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] {
+                return _stopping || (snapshot = _slot.Take()) != nullptr;
+            });
+            // The predicate only takes a snapshot when not stopping, a
+            // pending one stays in the slot for the next Start
+            if (_stopping)
+                return;
+        }
+
+        const bool idling = snapshot->idling;
+        bool resolved = false;
+        try
+        {
+            Resolve(*snapshot);
+            resolved = true;
+        }
+        catch (const std::exception&)
+        {
+            // The next snapshot is resolved from scratch
+            _hasWorkspace = _hasPrivacy = false;
+        }
+        _slot.Recycle(snapshot);
+
+        if (resolved)
+            _publish(_presence, idling);
+    }
+}
+
+const Presence& PresenceResolver::Resolve(const EditorSnapshot& snapshot)
+{
+    ScopedTimer timer(STAGE_RESOLVE);
+    const bool hasFile = !snapshot.fileName.empty();
+
+    if (snapshot.workspace && (!_hasWorkspace || _workspaceBuffer != snapshot.buffer))
+        LoadWorkspace(snapshot);
+
+    // Fields are only given a new revision when their text changes, the
+    // connection thread then skips the unchanged ones
+    _presence.enableButtonRepository = snapshot.buttonRepository;
+
+    if (snapshot.hideIfPrivate && hasFile)
+    {
+        if (!_hasPrivacy || _privacyBuffer != snapshot.buffer)
+        {
+            ScopedTimer privacyTimer(STAGE_PRIVACY);
+            std::filesystem::path parent = snapshot.directory;
+            _private = _fileFilter.IsPrivate((parent / snapshot.fileName).string());
+            _privacyBuffer = snapshot.buffer;
+            _hasPrivacy = true;
+        }
+
+        if (_private)
+        {
+            _presence.SetText(Presence::FIELD_DETAILS, "Private File");
+            _presence.SetText(Presence::FIELD_STATE, "");
+            _presence.SetText(Presence::FIELD_REPOSITORY_URL, "");
+            _presence.SetText(Presence::FIELD_SMALL_IMAGE, "");
+            _presence.SetText(Presence::FIELD_SMALL_TEXT, "");
+            _presence.SetText(Presence::FIELD_LARGE_TEXT, NPP_NAME);
+            _presence.SetText(Presence::FIELD_LARGE_IMAGE, NPP_DEFAULTIMAGE);
+            _counters.resolved.fetch_add(1, std::memory_order_relaxed);
+            return _presence;
+        }
+    }
+
+    std::string_view smallImage, smallText;
+    if (!snapshot.largeText || !hasFile)
+    {
+        _presence.SetText(Presence::FIELD_LARGE_IMAGE, NPP_DEFAULTIMAGE);
+        _presence.SetText(Presence::FIELD_LARGE_TEXT, NPP_NAME);
+    }
+    else
+    {
+        _presence.SetText(Presence::FIELD_LARGE_IMAGE, snapshot.largeImage);
+        Render(snapshot, snapshot.largeText);
+        _presence.SetText(Presence::FIELD_LARGE_TEXT, _text);
+        if (snapshot.largeImage != NPP_DEFAULTIMAGE)
+        {
+            smallImage = NPP_DEFAULTIMAGE;
+            smallText = NPP_NAME;
+        }
+    }
+    _presence.SetText(Presence::FIELD_SMALL_IMAGE, smallImage);
+    _presence.SetText(Presence::FIELD_SMALL_TEXT, smallText);
+
+    _presence.SetText(Presence::FIELD_REPOSITORY_URL,
+        snapshot.buttonRepository ? std::string_view(_repositoryUrl) : std::string_view());
+
+    Render(snapshot, hasFile ? snapshot.details : nullptr);
+    _presence.SetText(Presence::FIELD_DETAILS, _text);
+    Render(snapshot, hasFile ? snapshot.state : nullptr);
+    _presence.SetText(Presence::FIELD_STATE, _text);
+
+    _counters.resolved.fetch_add(1, std::memory_order_relaxed);
+    return _presence;
+}
+
+void PresenceResolver::LoadWorkspace(const EditorSnapshot& snapshot)
+{
+    ScopedTimer timer(STAGE_WORKSPACE);
+    const std::string& directory = snapshot.directory;
+    const WorkspaceInfo* workspace = nullptr;
+    try
+    {
+        workspace = &_workspaceCache.Lookup(directory);
+    }
+    catch (const std::exception&) { /* treated as no workspace */ }
+
+    if (workspace && workspace->found)
+    {
+        _workspaceName = workspace->name;
+        if (!workspace->repositoryRoot.empty())
+            _fileFilter.SelectDirectory(directory, workspace->repositoryRoot, true);
+        else
+            _fileFilter.SelectDirectory(directory, workspace->root, false);
+        _repositoryUrl = workspace->repositoryUrl;
+    }
+    else
+    {
+        const size_t separator = directory.find_last_of("\\/");
+        _workspaceName = separator != std::string::npos ? directory.substr(separator + 1) : directory;
+        _fileFilter.SelectDirectory(directory, std::string(), false);
+        _repositoryUrl.clear();
+    }
+
+    _workspaceBuffer = snapshot.buffer;
+    _hasWorkspace = true;
+    _hasPrivacy = false;
+    _counters.workspaceLoads.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PresenceResolver::Render(const EditorSnapshot& snapshot, const FormatProgram* format)
+{
+    _text.clear();
+    if (!format)
+        return;
+
+    ScopedTimer timer(STAGE_RENDER);
+    format->Render(_text, [&](FormatToken token) -> const std::string& {
+        return token == TOKEN_WORKSPACE ? _workspaceName : snapshot.props[token];
+    });
+}
+
+PresenceResolverStats PresenceResolver::GetStats() const noexcept
+{
+    PresenceResolverStats stats;
+    stats.posted = _counters.posted.load(std::memory_order_relaxed);
+    stats.dropped = _counters.dropped.load(std::memory_order_relaxed);
+    stats.resolved = _counters.resolved.load(std::memory_order_relaxed);
+    stats.workspaceLoads = _counters.workspaceLoads.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,149 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "FileFilter.hpp"
+#include "LatestSlot.hpp"
+#include "Presence.hpp"
+#include "PresenceFormat.h"
+#include "WorkspaceCache.hpp"
+
+/**
+ * Editor state captured on the UI thread. It only holds values that
+ * Notepad++ and Scintilla answer from memory; everything that touches the
+ * filesystem is left to PresenceResolver.
+ */
+struct EditorSnapshot
+{
+    // Formats of the config the snapshot was taken with, null if the field
+    // is hidden. formatOwner keeps the config snapshot that owns them alive
+    // until the resolver is done with them, null if the caller owns them
+    std::shared_ptr<const void> formatOwner;
+    const FormatProgram* details = nullptr;
+    const FormatProgram* state = nullptr;
+    const FormatProgram* largeText = nullptr; // null: no language image
+
+    bool hideIfPrivate = false;
+    bool buttonRepository = false;
+    bool workspace = false; // The workspace, privacy or repository URL is used
+    bool idling = false;
+
+    // Changes with every buffer notification, the workspace and the privacy
+    // of the file are only resolved again when it does
+    uint64_t buffer = 0;
+    std::string directory;
+    std::string fileName;   // Empty if there is no file
+    std::string largeImage; // Image of the language
+    // Every property but TOKEN_WORKSPACE, which is resolved
+    std::string props[TOKEN_COUNT];
+};
+
+struct PresenceResolverStats
+{
+    uint64_t posted = 0;
+    uint64_t dropped = 0;        // Replaced before the worker took them
+    uint64_t resolved = 0;
+    uint64_t workspaceLoads = 0; // Workspace lookups and ignore file selections
+};
+
+/**
+ * Second stage of an update. A worker thread takes the latest
+ * EditorSnapshot, finds its workspace, repository URL and privacy, renders
+ * the formats and publishes the finished Presence. The editor thread never
+ * waits for the filesystem; a snapshot posted while the worker is busy
+ * replaces the pending one.
+ */
+class PresenceResolver
+{
+public:
+    typedef std::function<void(const Presence&, bool isIdling)> PublishCallback;
+
+    PresenceResolver() = default;
+    ~PresenceResolver();
+
+    PresenceResolver(const PresenceResolver&) = delete;
+    PresenceResolver& operator=(const PresenceResolver&) = delete;
+
+    /**
+     * @brief Starts the worker, a running worker is kept
+     * @param publish Called from the worker with every resolved presence
+     * @return false if the thread could not be started
+     */
+    bool Start(PublishCallback publish) noexcept;
+
+    /**
+     * @brief Stops the worker, the pending snapshot is kept for the next
+     * Start
+     */
+    void Stop() noexcept;
+
+    /**
+     * @brief Hands a snapshot to the worker, never blocks on it
+     */
+    void Post(const EditorSnapshot& snapshot) noexcept;
+
+    /**
+     * @brief Resolves a snapshot on the calling thread
+     * @details Used by the worker, only one thread may call it at a time
+     */
+    const Presence& Resolve(const EditorSnapshot& snapshot);
+
+    /**
+     * @brief Snapshot of the counters, thread safe
+     */
+    PresenceResolverStats GetStats() const noexcept;
+
+private:
+    LatestSlot<EditorSnapshot> _slot;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stopping = false;
+    std::thread _worker;
+    PublishCallback _publish;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> posted{ 0 }, dropped{ 0 };
+        std::atomic<uint64_t> resolved{ 0 }, workspaceLoads{ 0 };
+    } _counters;
+
+    // Only used by the resolving thread
+    WorkspaceCache _workspaceCache;
+    FileFilter _fileFilter;
+    uint64_t _workspaceBuffer = 0; // Buffer the workspace was resolved for
+    bool _hasWorkspace = false;
+    std::string _workspaceName;
+    std::string _repositoryUrl;
+    uint64_t _privacyBuffer = 0;
+    bool _hasPrivacy = false;
+    bool _private = false;
+    Presence _presence;
+    // Scratch buffer the formats are rendered into
+    std::string _text;
+
+    void Run() noexcept;
+    void LoadWorkspace(const EditorSnapshot& snapshot);
+    void Render(const EditorSnapshot& snapshot, const FormatProgram* format);
+};
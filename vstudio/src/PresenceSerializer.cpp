@@ -0,0 +1,256 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "PresenceSerializer.hpp"
+
+#include <charconv>
+
+namespace
+{
+    constexpr char REPLACEMENT_CHARACTER[] = "\xEF\xBF\xBD";
+
+    template <typename T>
+    void AppendNumber(std::string& out, T value)
+    {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    // Writes the separator and the key of the next member of an object
+    void AppendKey(std::string& out, bool& first, std::string_view key)
+    {
+        if (!first)
+            out += ',';
+        first = false;
+        out += '"';
+        out += key;
+        out += "\":";
+    }
+
+    /**
+     * Length of the valid UTF-8 sequence at the start of the text. An invalid
+     * sequence returns 0 and its maximal valid prefix in the argument, which
+     * is replaced as a whole
+     */
+    size_t ValidSequenceLength(std::string_view text, size_t& invalidLength)
+    {
+        const unsigned char lead = static_cast<unsigned char>(text[0]);
+        size_t length = 0;
+        // Range of the second byte, it excludes the overlong forms, the
+        // surrogates and the code points above U+10FFFF
+        unsigned char low = 0x80, high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF)
+            length = 2;
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            length = 3;
+            if (lead == 0xE0) low = 0xA0;
+            if (lead == 0xED) high = 0x9F;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            length = 4;
+            if (lead == 0xF0) low = 0x90;
+            if (lead == 0xF4) high = 0x8F;
+        }
+        else
+        {
+            invalidLength = 1;
+            return 0;
+        }
+
+        for (size_t i = 1; i < length; i++)
+        {
+            if (i >= text.size())
+            {
+                invalidLength = i;
+                return 0;
+            }
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c < low || c > high)
+            {
+                invalidLength = i;
+                return 0;
+            }
+            low = 0x80;
+            high = 0xBF;
+        }
+        return length;
+    }
+}
+
+void PresenceSerializer::AppendEscaped(std::string& out, std::string_view text)
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    // Runs of characters that need no escape are copied at once
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80)
+            continue;
+
+        if (c >= 0x80)
+        {
+            size_t invalidLength = 0;
+            const size_t length = ValidSequenceLength(text.substr(i), invalidLength);
+            if (length != 0)
+            {
+                i += length - 1;
+                continue;
+            }
+            out.append(text.data() + run, i - run);
+            out += REPLACEMENT_CHARACTER;
+            i += invalidLength - 1;
+            run = i + 1;
+            continue;
+        }
+
+        out.append(text.data() + run, i - run);
+        run = i + 1;
+        switch (c)
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+        {
+            const char escape[] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF] };
+            out.append(escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    out.append(text.data() + run, text.size() - run);
+}
+
+const std::string& PresenceSerializer::Encoded(const Presence& presence, Presence::Field field)
+{
+    Fragment& fragment = _fragments[field];
+    const std::string& text = presence.Text(field);
+    const uint64_t revision = presence.revisions[field];
+
+    if (fragment.valid && (revision != 0 ? revision == fragment.revision : fragment.source == text))
+        return fragment.json;
+
+    fragment.json.clear();
+    fragment.json += '"';
+    AppendEscaped(fragment.json, text);
+    fragment.json += '"';
+    fragment.source = text;
+    fragment.revision = revision;
+    fragment.valid = true;
+    _fieldsEncoded++;
+    return fragment.json;
+}
+
+void PresenceSerializer::Serialize(std::string& out, const Presence& presence, std::string_view nonce, unsigned long pid)
+{
+    out += R"({"args":{"activity":)";
+
+    const size_t activityStart = out.size();
+    bool first = true;
+    out += '{';
+
+    const bool largeImage = !presence.largeImage.empty();
+    const bool largeText = presence.largeText.size() >= MIN_STRING_LENGTH;
+    const bool smallImage = !presence.smallImage.empty();
+    const bool smallText = presence.smallText.size() >= MIN_STRING_LENGTH;
+    if (largeImage || largeText || smallImage || smallText)
+    {
+        AppendKey(out, first, "assets");
+        bool firstAsset = true;
+        out += '{';
+        if (largeImage)
+        {
+            AppendKey(out, firstAsset, "large_image");
+            out += Encoded(presence, Presence::FIELD_LARGE_IMAGE);
+        }
+        if (largeText)
+        {
+            AppendKey(out, firstAsset, "large_text");
+            out += Encoded(presence, Presence::FIELD_LARGE_TEXT);
+        }
+        if (smallImage)
+        {
+            AppendKey(out, firstAsset, "small_image");
+            out += Encoded(presence, Presence::FIELD_SMALL_IMAGE);
+        }
+        if (smallText)
+        {
+            AppendKey(out, firstAsset, "small_text");
+            out += Encoded(presence, Presence::FIELD_SMALL_TEXT);
+        }
+        out += '}';
+    }
+
+    if (presence.enableButtonRepository && !presence.repositoryUrl.empty())
+    {
+        AppendKey(out, first, "buttons");
+        out += R"([{"label":"View Repository","url":)";
+        out += Encoded(presence, Presence::FIELD_REPOSITORY_URL);
+        out += "}]";
+    }
+
+    if (presence.details.size() >= MIN_STRING_LENGTH)
+    {
+        AppendKey(out, first, "details");
+        out += Encoded(presence, Presence::FIELD_DETAILS);
+    }
+
+    if (presence.state.size() >= MIN_STRING_LENGTH)
+    {
+        AppendKey(out, first, "state");
+        out += Encoded(presence, Presence::FIELD_STATE);
+    }
+
+    if (presence.startTime > 0)
+    {
+        AppendKey(out, first, "timestamps");
+        out += '{';
+        if (presence.endTime > 0)
+        {
+            out += R"("end":)";
+            AppendNumber(out, presence.endTime);
+            out += ',';
+        }
+        out += R"("start":)";
+        AppendNumber(out, presence.startTime);
+        out += '}';
+    }
+
+    if (first)
+    {
+        // Nothing to show, Discord clears the activity
+        out.resize(activityStart);
+        out += "null";
+    }
+    else
+    {
+        out += '}';
+    }
+
+    out += R"(,"pid":)";
+    AppendNumber(out, pid);
+    out += R"(},"cmd":"SET_ACTIVITY","nonce":")";
+    AppendEscaped(out, nonce);
+    out += "\"}";
+}
@@ -0,0 +1,75 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+#include "Presence.hpp"
+
+/**
+ * Streams the SET_ACTIVITY command of a presence into a buffer of the
+ * caller, normally the frame being written, so nothing is allocated once
+ * the buffers have grown. The escaped value of every text field is cached
+ * with the revision it came from, so only the fields that changed since
+ * the last command are escaped again; the rest is copied.
+ *
+ * The output is the same as the nlohmann::json DOM the command used to be
+ * built with: keys in alphabetical order and no whitespace. Invalid UTF-8
+ * is replaced with U+FFFD, where nlohmann::json threw and the presence was
+ * lost.
+ */
+class PresenceSerializer
+{
+public:
+    // Discord rejects texts shorter than this, they are left out
+    static constexpr size_t MIN_STRING_LENGTH = 2;
+
+    /**
+     * @brief Appends the command to the buffer
+     * @param out Buffer the JSON text is appended to, its contents are kept
+     * @param nonce Identifies the response of Discord
+     * @param pid Process the activity belongs to
+     */
+    void Serialize(std::string& out, const Presence& presence, std::string_view nonce, unsigned long pid);
+
+    /**
+     * @brief Number of text fields escaped so far, the others were cached
+     */
+    uint64_t FieldsEncoded() const noexcept { return _fieldsEncoded; }
+
+    /**
+     * @brief Appends the text escaped as the contents of a JSON string. Each
+     * invalid UTF-8 sequence is written as one U+FFFD, like nlohmann::json
+     * with error_handler_t::replace
+     */
+    static void AppendEscaped(std::string& out, std::string_view text);
+
+private:
+    struct Fragment
+    {
+        bool valid = false;
+        uint64_t revision = 0;
+        std::string source; // Compared when the presence has no revision
+        std::string json;   // Quoted and escaped value
+    };
+
+    Fragment _fragments[Presence::FIELD_COUNT];
+    uint64_t _fieldsEncoded = 0;
+
+    const std::string& Encoded(const Presence& presence, Presence::Field field);
+};
@@ -0,0 +1,164 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "ResponseScanner.hpp"
+
+namespace
+{
+    class Scanner
+    {
+    public:
+        explicit Scanner(std::string_view json) : _json(json) {}
+
+        bool Done()
+        {
+            SkipWhitespace();
+            return _pos == _json.size();
+        }
+
+        bool Consume(char c)
+        {
+            SkipWhitespace();
+            if (_pos < _json.size() && _json[_pos] == c)
+            {
+                _pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool Peek(char c)
+        {
+            SkipWhitespace();
+            return _pos < _json.size() && _json[_pos] == c;
+        }
+
+        // The contents of the string at the position, without the quotes
+        bool String(std::string_view& value)
+        {
+            if (!Consume('"'))
+                return false;
+
+            const size_t start = _pos;
+            while (_pos < _json.size())
+            {
+                const char c = _json[_pos++];
+                if (c == '\\')
+                    _pos++; // The escaped character cannot end the string
+                else if (c == '"')
+                {
+                    value = _json.substr(start, _pos - 1 - start);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Skips any value; objects and arrays only by their brackets
+        bool SkipValue()
+        {
+            SkipWhitespace();
+            if (_pos >= _json.size())
+                return false;
+
+            std::string_view ignored;
+            const char c = _json[_pos];
+            if (c == '"')
+                return String(ignored);
+
+            if (c != '{' && c != '[')
+            {
+                // Number or literal, up to the next separator
+                const size_t start = _pos;
+                while (_pos < _json.size() && _json[_pos] != ',' && _json[_pos] != '}' &&
+                    _json[_pos] != ']' && !IsWhitespace(_json[_pos]))
+                    _pos++;
+                return _pos > start;
+            }
+
+            size_t depth = 0;
+            while (_pos < _json.size())
+            {
+                const char d = _json[_pos];
+                if (d == '"')
+                {
+                    if (!String(ignored))
+                        return false;
+                    continue;
+                }
+                _pos++;
+                if (d == '{' || d == '[')
+                    depth++;
+                else if ((d == '}' || d == ']') && --depth == 0)
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        std::string_view _json;
+        size_t _pos = 0;
+
+        static bool IsWhitespace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        void SkipWhitespace()
+        {
+            while (_pos < _json.size() && IsWhitespace(_json[_pos]))
+                _pos++;
+        }
+    };
+}
+
+bool ScanResponse(std::string_view json, DiscordResponse& response) noexcept
+{
+    response = DiscordResponse();
+
+    Scanner scanner(json);
+    if (!scanner.Consume('{'))
+        return false;
+
+    if (!scanner.Consume('}'))
+    {
+        do
+        {
+            std::string_view key;
+            if (!scanner.String(key) || !scanner.Consume(':'))
+                return false;
+
+            std::string_view* member = key == "evt" ? &response.evt :
+                key == "nonce" ? &response.nonce : nullptr;
+            if (member && scanner.Peek('"'))
+            {
+                if (!scanner.String(*member))
+                    return false;
+            }
+            else
+            {
+                // A later member with the same key replaces the earlier one
+                if (member)
+                    *member = std::string_view();
+                if (!scanner.SkipValue())
+                    return false;
+            }
+        } while (scanner.Consume(','));
+
+        if (!scanner.Consume('}'))
+            return false;
+    }
+    return scanner.Done();
+}
@@ -0,0 +1,36 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string_view>
+
+/**
+ * Members of a Discord response that the worker looks at. They are views
+ * into the frame body: the text between the quotes, escapes not decoded.
+ * A member that is missing or not a string is empty
+ */
+struct DiscordResponse
+{
+    std::string_view evt;   // "ERROR" for a failed command
+    std::string_view nonce; // Nonce of the command answered
+};
+
+/**
+ * @brief Finds evt and nonce among the members of the top level object
+ * without building a DOM. Nested values are skipped, not validated
+ * @return false if the text is not a JSON object
+ */
+bool ScanResponse(std::string_view json, DiscordResponse& response) noexcept;
@@ -1,4 +1,4 @@
-// Copyright (C) 2022 -2025 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -15,12 +15,11 @@
 
 #include "TextEditorInfo.h"
 #include "PluginInterface.h"
-#include "StringBuilder.h"
 #include "PluginUtil.h"
+#include "Metrics.hpp"
 
 #include <cctype>
 #include <Shlwapi.h>
-#include <filesystem>
 
 #ifdef _DEBUG
 	#include <cstdio>
@@ -45,104 +44,94 @@ TextEditorInfo::Property::operator =(const std::string& value)
 	return *this;
 }
 
-TextEditorInfo::TextEditorInfo()
+void TextEditorInfo::LoadEditorStatus(unsigned reasons, const EditorQuery& query) noexcept
 {
-	for (size_t i = 0; i < ARRAYSIZE(TOKENS); i++)
-	{
-		props[i].key = TOKENS[i];
-	}
-}
-
-void TextEditorInfo::LoadEditorStatus() noexcept
-{
-	static_assert(ARRAYSIZE(TOKENS) != 9, "TOKENS and PresenceTextFormat::props");
-
+	ScopedTimer timer(STAGE_EDITOR_STATUS);
 	HWND hWndScin = ::GetCurrentScintilla();
 	if (!hWndScin) return;
 
-	_info.name = GetEditorTextProperty(NPPM_GETFILENAME);
-	_info.extension = GetEditorTextProperty(NPPM_GETEXTPART);
+	// The file name, language and workspace only change with the buffer, so
+	// an update caused only by caret movement or typing skips them
+	if (!_bufferLoaded)
+		reasons = UPDATE_ALL;
+	const bool bufferChanged = (reasons & UPDATE_BUFFER) != 0;
+	const unsigned tokens = query.tokens;
 
-	std::string lowerExtension = _info.extension;
-
-	std::transform(lowerExtension.begin(), lowerExtension.end(), lowerExtension.begin(),
-		[](unsigned char c){
-			return static_cast<char>(std::tolower(c));
-		});
-	
-	_lang_info = LanguageInfo::GetLanguageInfo(lowerExtension);
-
-	// Save old values to check if something changed for idle detection
-	int oldCurrentLine    = props[2],
-		oldCurrentColumn  = props[3];
-	__int64 oldFileLength = _lastFileLength;
-
-	props[0] = _info.name;
-	props[1] = _info.extension;
-
-	props[2] = static_cast<int>(NppSendMessage(nppData._nppHandle, NPPM_GETCURRENTLINE, 0, 0)) + 1;
-	props[3] = static_cast<int>(NppSendMessage(nppData._nppHandle, NPPM_GETCURRENTCOLUMN, 0, 0)) + 1;
+	if (bufferChanged)
+	{
+		_info.name = GetEditorTextProperty(NPPM_GETFILENAME);
+		_info.extension = GetEditorTextProperty(NPPM_GETEXTPART);
+		_currentDir = GetEditorTextProperty(NPPM_GETCURRENTDIRECTORY);
+		_bufferLoaded = true;
+		_loaded = LOADED_NONE;
+		_bufferId++;
+
+		props[TOKEN_FILE] = _info.name;
+		props[TOKEN_EXTENSION] = _info.extension;
+	}
+	else if (reasons & UPDATE_LANGUAGE)
+	{
+		_loaded &= ~(LOADED_LANGUAGE | LOADED_LANGUAGE_NAMES);
+	}
 
-	props[4] = GetFormattedCurrentFileSize(hWndScin, &_lastFileLength);
-	props[5] = static_cast<int>(NppSendMessage(hWndScin, SCI_GETLINECOUNT, 0, 0));
+	// Buffer level properties are only loaded when something needs them, and
+	// at most once per buffer
+	constexpr unsigned LANGUAGE_TOKENS = (1u << TOKEN_LANG) | (1u << TOKEN_LANG_TITLE) | (1u << TOKEN_LANG_UPPER);
+	const bool needsLanguageNames = (tokens & LANGUAGE_TOKENS) != 0;
+	if ((query.language || needsLanguageNames) && !(_loaded & LOADED_LANGUAGE))
+	{
+		std::string lowerExtension = _info.extension;
+
+		std::transform(lowerExtension.begin(), lowerExtension.end(), lowerExtension.begin(),
+			[](unsigned char c){
+				return static_cast<char>(std::tolower(c));
+			});
+		
+		_lang_info = LanguageInfo::GetLanguageInfo(lowerExtension);
+		_loaded |= LOADED_LANGUAGE;
+	}
 
-	std::string langName = _lang_info._name;
+	if (needsLanguageNames && !(_loaded & LOADED_LANGUAGE_NAMES))
+	{
+		std::string langName = _lang_info._name;
 
-	props[6] = GetStringCase(langName, false); // lower case
+		props[TOKEN_LANG] = GetStringCase(langName, false); // lower case
 
-	langName[0] = (char)std::toupper(langName[0]);
-	props[7] = langName; // first letter in upper case
-	props[8] = GetStringCase(langName, true); // upper case
+		langName[0] = (char)std::toupper(langName[0]);
+		props[TOKEN_LANG_TITLE] = langName; // first letter in upper case
+		props[TOKEN_LANG_UPPER] = GetStringCase(langName, true); // upper case
+		_loaded |= LOADED_LANGUAGE_NAMES;
+	}
 
-	props[9] = static_cast<int>(::NppSendMessage(hWndScin, SCI_GETCURRENTPOS, 0, 0) + 1L);
-	
-	// Determine workspace
-	std::string currentDir = GetEditorTextProperty(NPPM_GETCURRENTDIRECTORY);
-	std::string workspace, absolutePathWorkspace, repoUrl;
+	// The caret and size properties change all the time, they are loaded on
+	// every update but only if a format or the idle detection uses them
+	const int oldCurrentLine = _currentLine, oldCurrentColumn = _currentColumn;
+	const __int64 oldFileLength = _lastFileLength;
 
-	if (SearchWorkspace(currentDir, workspace, absolutePathWorkspace, repoUrl))
+	if (query.idleDetection || (tokens & ((1u << TOKEN_LINE) | (1u << TOKEN_COLUMN))))
 	{
-		props[10] = workspace;
-		_fileFilter.LoadGitignore((std::filesystem::path(absolutePathWorkspace) / ".gitignore").string());
+		_currentLine = static_cast<int>(NppSendMessage(nppData._nppHandle, NPPM_GETCURRENTLINE, 0, 0)) + 1;
+		_currentColumn = static_cast<int>(NppSendMessage(nppData._nppHandle, NPPM_GETCURRENTCOLUMN, 0, 0)) + 1;
+		if (tokens & (1u << TOKEN_LINE))
+			props[TOKEN_LINE] = _currentLine;
+		if (tokens & (1u << TOKEN_COLUMN))
+			props[TOKEN_COLUMN] = _currentColumn;
 	}
-	else
-	{
-		workspace = currentDir;
-		props[10] = workspace.find_last_of("\\") != std::string::npos ?
-				workspace.substr(workspace.find_last_of("\\/") + 1) :
-			workspace;
-	}
-	currentRepositoryUrl = repoUrl;
-
-	_textEditorIdling = (oldCurrentLine == (int)props[2] && oldCurrentColumn == (int)props[3] && oldFileLength == _lastFileLength);
-}
 
-void TextEditorInfo::WriteFormat(std::string& buffer, const char* format) noexcept
-{
-	char buf[128] = { '\0' };
-	StringBuilder builder(buf, sizeof buf);
-	bool _continue;
-	for (size_t i = 0; format[i] != '\0' && !builder.IsFull(); i++)
+	if (query.idleDetection || (tokens & (1u << TOKEN_SIZE)))
 	{
-		_continue = false;
-		if (format[i] == '%' && format[i + 1] == '(' && format[i + 2] != '\0')
-		{
-			for (size_t k = 0; k < ARRAYSIZE(props); k++)
-			{
-				if (format[i + 2] == props[k].key[2] && ContainsTag(format, props[k].key.c_str(), i))
-				{
-					builder.Append(props[k].value);
-					i += props[k].key.length() - 1;
-					_continue = true;
-					break;
-				}
-			}
-		}
-		if (_continue) continue;
-		builder.Append(format[i]);
+		_lastFileLength = static_cast<__int64>(::NppSendMessage(hWndScin, SCI_GETLENGTH, 0, 0));
+		if (tokens & (1u << TOKEN_SIZE))
+			props[TOKEN_SIZE] = GetFormattedFileSize(_lastFileLength);
 	}
 
-	buffer = buf;
+	if (tokens & (1u << TOKEN_LINE_COUNT))
+		props[TOKEN_LINE_COUNT] = static_cast<int>(NppSendMessage(hWndScin, SCI_GETLINECOUNT, 0, 0));
+	if (tokens & (1u << TOKEN_POSITION))
+		props[TOKEN_POSITION] = static_cast<int>(::NppSendMessage(hWndScin, SCI_GETCURRENTPOS, 0, 0) + 1L);
+
+	_textEditorIdling = query.idleDetection && oldCurrentLine == _currentLine &&
+		oldCurrentColumn == _currentColumn && oldFileLength == _lastFileLength;
 }
 
 bool TextEditorInfo::IsFileInfoEmpty() const noexcept
@@ -155,93 +144,40 @@ const LanguageInfo& TextEditorInfo::GetLanguageInfo() const noexcept
 	return _lang_info;
 }
 
-bool TextEditorInfo::IsCurrentFilePrivate() noexcept
-{
-	std::filesystem::path parent = GetEditorTextProperty(NPPM_GETCURRENTDIRECTORY);
-	return _fileFilter.IsPrivate((parent / _info.name).string());
-}
-
-bool TextEditorInfo::ContainsTag(const char* format, const char* tag, size_t pos) noexcept
+EditorQuery MakeEditorQuery(const PresenceOptions& options) noexcept
 {
-	for (size_t i = 0; tag[i] != '\0'; i++)
-		if (format[pos] == '\0' || format[pos++] != tag[i])
-			return false;
-	return true;
+	EditorQuery query;
+	query.tokens = (options.hideDetails ? 0 : options.details->GetTokenMask()) |
+		(options.hideState ? 0 : options.state->GetTokenMask()) |
+		(options.langImage ? options.largeText->GetTokenMask() : 0);
+	query.idleDetection = !options.hideIdleStatus;
+	query.workspace = options.hideIfPrivate || options.buttonRepository ||
+		(query.tokens & (1u << TOKEN_WORKSPACE));
+	query.language = options.langImage;
+	return query;
 }
 
-bool TextEditorInfo::SearchWorkspace(std::filesystem::path currentDir, std::string& workspace, std::string& absolutePathWorkspace, std::string& repoUrl) noexcept
+void ApplyPresenceOptions(const PresenceOptions& options, const EditorQuery& query,
+	EditorSnapshot& snapshot) noexcept
 {
-	while (!currentDir.empty())
-	{
-		bool existsGitignoreFile = std::filesystem::exists(currentDir / ".gitignore");
-		bool existsGitFolder = std::filesystem::exists(currentDir / ".git");
-		if (existsGitFolder || existsGitignoreFile)
-		{
-			absolutePathWorkspace = currentDir.string();
-			workspace = currentDir.string();
-			workspace.find_last_of("\\") != std::string::npos ?
-				workspace = workspace.substr(workspace.find_last_of("\\/") + 1) :
-				workspace = workspace;
-			if (existsGitFolder)
-				GetRepositoryUrl((currentDir / ".git" / "config").string(), repoUrl);
-			return true;
-		}
-
-		auto tempCurrentDir = currentDir;
-		currentDir = currentDir.parent_path();
-		if (currentDir == tempCurrentDir) // root reached
-			break;
-	}
-	return false;
+	snapshot.formatOwner = options.formatOwner;
+	snapshot.details = options.hideDetails ? nullptr : options.details;
+	snapshot.state = options.hideState ? nullptr : options.state;
+	snapshot.largeText = options.langImage ? options.largeText : nullptr;
+	snapshot.hideIfPrivate = options.hideIfPrivate;
+	snapshot.buttonRepository = options.buttonRepository;
+	snapshot.workspace = query.workspace;
 }
 
-void TextEditorInfo::GetRepositoryUrl(const std::string& fileConfig, std::string& url) noexcept
+void TextEditorInfo::CaptureSnapshot(EditorSnapshot& snapshot) const
 {
-	if (std::filesystem::exists(fileConfig))
-	{
-		FILE* file = nullptr;
-		fopen_s(&file, fileConfig.c_str(), "r");
-		if (file != nullptr)
-		{
-			char line[512] = { '\0' };
-			bool inRemoteOrigin = false;
-			while (fgets(line, sizeof line, file) != nullptr)
-			{
-				if (line[0] == '[')
-					inRemoteOrigin = (strstr(line, "[remote \"origin\"]") != nullptr);
-				else if (inRemoteOrigin)
-				{
-					char* pos = strstr(line, "url = ");
-					if (pos != nullptr)
-					{
-						pos += 6; // move past "url = "
-						char* end = strchr(pos, '\n');
-						if (end != nullptr) *end = '\0';
-						url = pos;
-						// Convert SSH URL to HTTPS if necessary
-						if (url.find("git@") == 0)
-						{
-							size_t colonPos = url.find(':');
-							if (colonPos != std::string::npos)
-							{
-								std::string domain = url.substr(4, colonPos - 4); // Skip "git@"
-								std::string path = url.substr(colonPos + 1);
-								url = "https://" + domain + "/" + path;
-							}
-						}
-						else if (url.find("http://") == 0)
-							url.replace(0, 7, "https://");
-						break;
-					}
-				}
-			}
-			fclose(file);
-		}
-	}
-	else
-	{
-		url.clear();
-	}
+	snapshot.buffer = _bufferId;
+	snapshot.directory = _currentDir;
+	snapshot.fileName = _info.name;
+	snapshot.largeImage = _lang_info._large_image;
+	snapshot.idling = _textEditorIdling;
+	for (int token = 0; token < TOKEN_COUNT; token++)
+		snapshot.props[token] = props[token].value;
 }
 
 std::string& TextEditorInfo::GetStringCase(std::string& s, bool case_) noexcept
@@ -317,15 +253,9 @@ std::string TextEditorInfo::GetEditorTextProperty(int prop)
 	return buffer;
 }
 
-std::string TextEditorInfo::GetFormattedCurrentFileSize(HWND hWndScin, int64_t* fileSize)
+std::string TextEditorInfo::GetFormattedFileSize(int64_t fileSize)
 {
 	char sizeFormattedBuf[48] = { '\0' };
-	int64_t fileSizeLocal = 0;
-
-	StrFormatByteSize64A(fileSizeLocal = ::NppSendMessage(hWndScin, SCI_GETLENGTH, 0, 0),
-		sizeFormattedBuf, 48);
-
-	if (fileSize)
-		*fileSize = fileSizeLocal;
+	StrFormatByteSize64A(fileSize, sizeFormattedBuf, 48);
 	return std::string(sizeFormattedBuf);
-}
\ No newline at end of file
+}
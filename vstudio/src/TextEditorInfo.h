@@ -1,4 +1,4 @@
-// Copyright (C) 2022 - 2025 Zukaritasu
+// Copyright (C) 2022 - 2026 Zukaritasu
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -18,18 +18,57 @@
 #include "LanguageInfo.h"
 
 #include <Windows.h>
+#include <memory>
 #include <string>
 #include <filesystem>
 
-#include "FileFilter.hpp"
+#include "UpdateScheduler.h"
+#include "PresenceFormat.h"
+#include "PresenceResolver.hpp"
 
-const LPCSTR TOKENS[] =
+/**
+ * What an update needs from the editor. Properties that no format and no
+ * option uses are not requested from Notepad++ or Scintilla.
+ */
+struct EditorQuery
 {
-	"%(file)", "%(extension)", "%(line)", "%(column)",
-	"%(size)", "%(line_count)", "%(lang)", "%(Lang)",
-	"%(LANG)", "%(position)", "%(workspace)"
+	unsigned tokens      = ~0u;  // FormatProgram::GetTokenMask of the shown formats
+	bool idleDetection   = true; // line, column and length for IsTextEditorIdling
+	bool workspace       = true; // resolved by PresenceResolver, off the editor thread
+	bool language        = true; // GetLanguageInfo
 };
 
+/**
+ * Options of the config that decide what an update asks the editor and
+ * how PresenceResolver builds the presence. The formats are never null,
+ * the hide options say which of them are shown.
+ */
+struct PresenceOptions
+{
+	std::shared_ptr<const void> formatOwner; // See EditorSnapshot::formatOwner
+	const FormatProgram* details   = nullptr;
+	const FormatProgram* state     = nullptr;
+	const FormatProgram* largeText = nullptr;
+	bool hideDetails      = false;
+	bool hideState        = false;
+	bool langImage        = true;
+	bool hideIfPrivate    = false;
+	bool buttonRepository = false;
+	bool hideIdleStatus   = false;
+};
+
+/**
+ * @brief Properties that an update with the given options needs
+ */
+EditorQuery MakeEditorQuery(const PresenceOptions& options) noexcept;
+
+/**
+ * @brief Writes the options part of a snapshot filled by CaptureSnapshot
+ * @param query The query made by MakeEditorQuery for the same options
+ */
+void ApplyPresenceOptions(const PresenceOptions& options, const EditorQuery& query,
+	EditorSnapshot& snapshot) noexcept;
+
 class TextEditorInfo
 {
 public:
@@ -39,22 +78,32 @@ public:
 		std::string extension;
 	};
 
-	TextEditorInfo();
+	TextEditorInfo() = default;
 
-	void LoadEditorStatus() noexcept;
-	void WriteFormat(std::string& buffer, const char* format) noexcept;
+	void LoadEditorStatus(unsigned reasons = UPDATE_ALL, const EditorQuery& query = EditorQuery()) noexcept;
 	bool IsFileInfoEmpty() const noexcept;
 	const LanguageInfo& GetLanguageInfo() const noexcept;
-	const std::string& GetCurrentRepositoryUrl() const noexcept { return currentRepositoryUrl; }
-	bool IsCurrentFilePrivate() noexcept;
 	bool IsTextEditorIdling() const noexcept { return _textEditorIdling; }
 
+	/**
+	 * @brief Copies the loaded properties into the snapshot that
+	 * PresenceResolver completes. Only the editor part is written
+	 */
+	void CaptureSnapshot(EditorSnapshot& snapshot) const;
+
 	static std::wstring GetEditorTextPropertyW(int prop);
 
 private:
+	// Buffer level properties that are already loaded for the current buffer
+	enum LoadedFlags : unsigned
+	{
+		LOADED_NONE           = 0,
+		LOADED_LANGUAGE       = 1 << 0,
+		LOADED_LANGUAGE_NAMES = 1 << 1
+	};
+
 	struct Property
 	{
-		std::string key;
 		std::string value;
 
 		Property& operator =(int value);
@@ -65,22 +114,25 @@ private:
 		operator __int64() const noexcept { return std::atoll(value.c_str()); }
 	};
 
-	std::string currentRepositoryUrl{};
+	std::string _currentDir{};
 
-	Property props[ARRAYSIZE(TOKENS)];
+	Property props[TOKEN_COUNT];
 	FileInfo _info{};
 	LanguageInfo _lang_info;
-	FileFilter _fileFilter{};
 	bool _textEditorIdling = false;
+	bool _bufferLoaded = false;
+	unsigned _loaded = LOADED_NONE;
+	// Counts the buffer notifications, see EditorSnapshot::buffer
+	uint64_t _bufferId = 0;
+	int _currentLine = 0;
+	int _currentColumn = 0;
 	__int64 _lastFileLength = 0;
 
-	bool ContainsTag(const char* format, const char* tag, size_t pos) noexcept;
-	bool SearchWorkspace(std::filesystem::path currentDir, std::string& workspace, std::string& absolutePathWorkspace, std::string& repoUrl) noexcept;
-	void GetRepositoryUrl(const std::string& fileConfig, std::string& url) noexcept;
 	// true = upper, false = lower
 	std::string& GetStringCase(std::string& s, bool case_) noexcept;
 
 
 	static std::string GetEditorTextProperty(int prop);
-	static std::string GetFormattedCurrentFileSize(HWND hWndScin, int64_t* fileSize = nullptr);
+
+	static std::string GetFormattedFileSize(int64_t fileSize);
 };
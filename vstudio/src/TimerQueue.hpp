@@ -0,0 +1,168 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Deadlines of a fixed set of timers, kept in a binary min-heap indexed by
+ * timer, so the owner thread can sleep exactly until the earliest one.
+ * Scheduling a timer again moves its deadline instead of adding an entry,
+ * the heap never holds more entries than there are timers.
+ */
+class TimerQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static constexpr uint32_t INFINITE_TIMEOUT = 0xFFFFFFFF;
+
+    explicit TimerQueue(size_t timerCount) : _position(timerCount, NOT_SCHEDULED)
+    {
+        _heap.reserve(timerCount);
+    }
+
+    /**
+     * @brief Sets the deadline of the timer, replacing the previous one
+     */
+    void Schedule(size_t timer, TimePoint deadline)
+    {
+        size_t index = _position[timer];
+        if (index == NOT_SCHEDULED)
+        {
+            index = _heap.size();
+            _heap.push_back({ deadline, timer });
+            _position[timer] = index;
+        }
+        else
+        {
+            _heap[index].deadline = deadline;
+        }
+        SiftDown(SiftUp(index));
+    }
+
+    void Cancel(size_t timer) noexcept
+    {
+        const size_t index = _position[timer];
+        if (index == NOT_SCHEDULED)
+            return;
+
+        _position[timer] = NOT_SCHEDULED;
+        const size_t last = _heap.size() - 1;
+        if (index != last)
+        {
+            _heap[index] = _heap[last];
+            _position[_heap[index].timer] = index;
+        }
+        _heap.pop_back();
+        if (index < _heap.size())
+            SiftDown(SiftUp(index));
+    }
+
+    void Clear() noexcept
+    {
+        for (const Entry& entry : _heap)
+            _position[entry.timer] = NOT_SCHEDULED;
+        _heap.clear();
+    }
+
+    bool IsScheduled(size_t timer) const noexcept { return _position[timer] != NOT_SCHEDULED; }
+    bool Empty() const noexcept { return _heap.empty(); }
+
+    /**
+     * @brief Removes the earliest timer if its deadline has passed
+     * @return false if no timer is due
+     */
+    bool PopExpired(TimePoint now, size_t& timer) noexcept
+    {
+        if (_heap.empty() || _heap.front().deadline > now)
+            return false;
+        timer = _heap.front().timer;
+        Cancel(timer);
+        return true;
+    }
+
+    /**
+     * @brief Milliseconds until the earliest deadline, rounded up so the
+     * timer is due when the wait ends
+     */
+    uint32_t TimeoutMs(TimePoint now) const noexcept
+    {
+        if (_heap.empty())
+            return INFINITE_TIMEOUT;
+        const TimePoint deadline = _heap.front().deadline;
+        if (deadline <= now)
+            return 0;
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+        return ms >= INFINITE_TIMEOUT ? INFINITE_TIMEOUT - 1 : static_cast<uint32_t>(ms);
+    }
+
+private:
+    static constexpr size_t NOT_SCHEDULED = static_cast<size_t>(-1);
+
+    struct Entry
+    {
+        TimePoint deadline;
+        size_t timer;
+    };
+
+    std::vector<Entry> _heap;
+    // Index in _heap of every timer
+    std::vector<size_t> _position;
+
+    void Swap(size_t a, size_t b) noexcept
+    {
+        std::swap(_heap[a], _heap[b]);
+        _position[_heap[a].timer] = a;
+        _position[_heap[b].timer] = b;
+    }
+
+    size_t SiftUp(size_t index) noexcept
+    {
+        while (index > 0)
+        {
+            const size_t parent = (index - 1) / 2;
+            if (!(_heap[index].deadline < _heap[parent].deadline))
+                break;
+            Swap(index, parent);
+            index = parent;
+        }
+        return index;
+    }
+
+    void SiftDown(size_t index) noexcept
+    {
+        const size_t size = _heap.size();
+        while (true)
+        {
+            size_t smallest = index;
+            const size_t left = index * 2 + 1, right = left + 1;
+            if (left < size && _heap[left].deadline < _heap[smallest].deadline)
+                smallest = left;
+            if (right < size && _heap[right].deadline < _heap[smallest].deadline)
+                smallest = right;
+            if (smallest == index)
+                return;
+            Swap(index, smallest);
+            index = smallest;
+        }
+    }
+};
@@ -0,0 +1,279 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _WIN32
+
+#include "UnixSocketTransport.hpp"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS, SO_NOSIGPIPE is set on the socket instead
+#endif
+
+namespace
+{
+    int Remaining(std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return 0;
+        return static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+    }
+
+    bool SetNonBlocking(int fd) noexcept
+    {
+        const int flags = ::fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 &&
+               ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+    }
+
+    // Waits for the events on the descriptor, false on timeout or error
+    bool PollFor(int fd, short events, int timeoutMs) noexcept
+    {
+        pollfd pfd{ fd, events, 0 };
+        int result;
+        do
+        {
+            result = ::poll(&pfd, 1, timeoutMs);
+        } while (result < 0 && errno == EINTR);
+        return result > 0 && (pfd.revents & (events | POLLHUP | POLLERR));
+    }
+}
+
+UnixSocketTransport::UnixSocketTransport() noexcept
+{
+    if (::pipe(_wakePipe) != 0 || !SetNonBlocking(_wakePipe[0]) || !SetNonBlocking(_wakePipe[1]))
+    {
+        for (int& fd : _wakePipe)
+        {
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+UnixSocketTransport::~UnixSocketTransport()
+{
+    Disconnect();
+    for (int fd : _wakePipe)
+        if (fd >= 0)
+            ::close(fd);
+}
+
+std::string UnixSocketTransport::RuntimeDirectory()
+{
+    for (const char* name : { "XDG_RUNTIME_DIR", "TMPDIR", "TMP", "TEMP" })
+    {
+        const char* value = std::getenv(name);
+        if (value && *value)
+            return value;
+    }
+    return "/tmp";
+}
+
+std::string UnixSocketTransport::Endpoint(int index) const
+{
+    return RuntimeDirectory() + "/discord-ipc-" + std::to_string(index);
+}
+
+uint32_t UnixSocketTransport::ProbeEndpoints() const
+{
+    const std::string directory = RuntimeDirectory() + "/discord-ipc-";
+    uint32_t found = 0;
+    struct stat info;
+    for (int i = 0; i < MAX_ENDPOINTS; i++)
+    {
+        if (::stat((directory + std::to_string(i)).c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+            found |= 1u << i;
+    }
+    return found;
+}
+
+bool UnixSocketTransport::Connect(int index)
+{
+    Disconnect();
+
+    const std::string path = Endpoint(index);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        return false;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    _socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_socket < 0)
+        return false;
+
+#ifdef SO_NOSIGPIPE
+    const int on = 1;
+    ::setsockopt(_socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    // A missing socket fails at once, there is nothing to wait for
+    if (::connect(_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        !SetNonBlocking(_socket))
+    {
+        Disconnect();
+        return false;
+    }
+    return true;
+}
+
+void UnixSocketTransport::Disconnect() noexcept
+{
+    if (_socket >= 0)
+    {
+        ::close(_socket);
+        _socket = -1;
+    }
+    _readBuffer.clear();
+    _readOffset = 0;
+}
+
+bool UnixSocketTransport::Write(const void* data, size_t size, uint32_t timeoutMs)
+{
+    if (_socket < 0)
+        return false;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    const char* in = static_cast<const char*>(data);
+    size_t done = 0;
+    while (done < size)
+    {
+        const ssize_t sent = ::send(_socket, in + done, size - done, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            done += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+            PollFor(_socket, POLLOUT, Remaining(deadline)))
+            continue;
+        return false;
+    }
+    return true;
+}
+
+bool UnixSocketTransport::Read(void* data, size_t size, uint32_t timeoutMs)
+{
+    if (_socket < 0)
+        return false;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    char* out = static_cast<char*>(data);
+    size_t done = TakeBuffered(out, size);
+    while (done < size)
+    {
+        const ssize_t received = ::recv(_socket, out + done, size - done, 0);
+        if (received > 0)
+        {
+            done += static_cast<size_t>(received);
+            continue;
+        }
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+            PollFor(_socket, POLLIN, Remaining(deadline)))
+            continue;
+        return false; // EOF, error or timeout
+    }
+    return true;
+}
+
+IpcTransport::WaitResult UnixSocketTransport::Wait(uint32_t timeoutMs)
+{
+    if (Buffered() > 0)
+        return WaitResult::Readable;
+
+    pollfd fds[2] = {
+        { _wakePipe[0], POLLIN, 0 },
+        { _socket, POLLIN, 0 }
+    };
+    const nfds_t count = _socket >= 0 ? 2 : 1;
+    const int timeout = timeoutMs == INFINITE_TIMEOUT ? -1 : static_cast<int>(timeoutMs);
+
+    int result;
+    do
+    {
+        result = ::poll(fds, count, timeout);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0)
+        return WaitResult::Failed;
+    if (result == 0)
+        return WaitResult::Timeout;
+    if (fds[0].revents & POLLIN)
+    {
+        DrainWakePipe();
+        return WaitResult::Woken;
+    }
+    return Receive() ? WaitResult::Readable : WaitResult::Failed;
+}
+
+void UnixSocketTransport::Wake() noexcept
+{
+    if (_wakePipe[1] >= 0)
+    {
+        const char byte = 1;
+        // A full pipe already wakes the reader
+        [[maybe_unused]] ssize_t written = ::write(_wakePipe[1], &byte, 1);
+    }
+}
+
+bool UnixSocketTransport::Receive() noexcept
+{
+    ssize_t received;
+    do
+    {
+        received = ::recv(_socket, _chunk, READ_CHUNK, 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received <= 0)
+        return false;
+
+    try
+    {
+        _readBuffer.insert(_readBuffer.end(), _chunk, _chunk + received);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+    return true;
+}
+
+void UnixSocketTransport::DrainWakePipe() noexcept
+{
+    char buffer[64];
+    while (::read(_wakePipe[0], buffer, sizeof(buffer)) > 0)
+    {
+    }
+}
+
+#endif // !_WIN32
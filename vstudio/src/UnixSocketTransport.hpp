@@ -0,0 +1,64 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "IpcTransport.hpp"
+
+/**
+ * The Unix domain socket that Discord creates on Linux and macOS, in the
+ * first directory set of XDG_RUNTIME_DIR, TMPDIR, TMP or TEMP, or /tmp.
+ * The socket is non-blocking and every wait goes through poll, together
+ * with a self-pipe for Wake.
+ */
+class UnixSocketTransport : public IpcTransport
+{
+public:
+    UnixSocketTransport() noexcept;
+    ~UnixSocketTransport() override;
+
+    UnixSocketTransport(const UnixSocketTransport&) = delete;
+    UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+
+    bool Connect(int index) override;
+    void Disconnect() noexcept override;
+    bool IsConnected() const noexcept override { return _socket >= 0; }
+    bool Write(const void* data, size_t size, uint32_t timeoutMs) override;
+    bool Read(void* data, size_t size, uint32_t timeoutMs) override;
+    WaitResult Wait(uint32_t timeoutMs) override;
+    void Wake() noexcept override;
+    uint32_t ProbeEndpoints() const override;
+    std::string Endpoint(int index) const override;
+
+    /**
+     * @brief Directory that holds the discord-ipc-N sockets
+     */
+    static std::string RuntimeDirectory();
+
+private:
+    static constexpr size_t READ_CHUNK = 4096;
+
+    int _socket = -1;
+    int _wakePipe[2] = { -1, -1 };
+    char _chunk[READ_CHUNK];
+
+    // Receives what is available into _readBuffer, false on EOF or error
+    bool Receive() noexcept;
+    void DrainWakePipe() noexcept;
+};
+
+#endif // !_WIN32
@@ -0,0 +1,76 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "UpdateScheduler.h"
+#include "PluginInterface.h"
+
+unsigned NotificationReasons(unsigned code) noexcept
+{
+	switch (code)
+	{
+	case NPPN_BUFFERACTIVATED:
+	case NPPN_FILERENAMED:
+	case NPPN_FILESAVED: // may be a .gitignore or a moved file
+		return UPDATE_BUFFER;
+	case NPPN_LANGCHANGED:
+		return UPDATE_LANGUAGE;
+	case SCN_UPDATEUI:
+		return UPDATE_CURSOR;
+	default:
+		return UPDATE_NONE;
+	}
+}
+
+bool UpdateScheduler::Notify(unsigned reasons, uint64_t now) noexcept
+{
+	_stats.received++;
+
+	const bool wasPending = _dirty != UPDATE_NONE;
+	_dirty |= reasons;
+
+	// A buffer switch changes everything shown in the presence, so it is
+	// pushed without waiting for the window to expire
+	if ((reasons & UPDATE_BUFFER) || FlushDelay(now) == 0)
+	{
+		_stats.immediate++;
+		return true;
+	}
+
+	if (wasPending)
+		_stats.merged++;
+	return false;
+}
+
+uint64_t UpdateScheduler::FlushDelay(uint64_t now) const noexcept
+{
+	if (!_hasRun || now < _lastRun)
+		return 0;
+
+	const uint64_t elapsed = now - _lastRun;
+	return elapsed >= _interval ? 0 : _interval - elapsed;
+}
+
+unsigned UpdateScheduler::TakeDirty(uint64_t now) noexcept
+{
+	const unsigned dirty = _dirty;
+	if (dirty == UPDATE_NONE)
+		return UPDATE_NONE;
+
+	_dirty = UPDATE_NONE;
+	_lastRun = now;
+	_hasRun = true;
+	_stats.processed++;
+	return dirty;
+}
@@ -0,0 +1,96 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Kind of change that made the presence dirty. The reasons of a burst of
+ * notifications are merged so that a single rebuild can skip the work that
+ * the merged events did not invalidate.
+ */
+enum UpdateReason : unsigned
+{
+	UPDATE_NONE     = 0,
+	UPDATE_CURSOR   = 1 << 0, // SCN_UPDATEUI: caret, selection, scroll or text
+	UPDATE_BUFFER   = 1 << 1, // NPPN_BUFFERACTIVATED, NPPN_FILERENAMED, NPPN_FILESAVED
+	UPDATE_LANGUAGE = 1 << 2, // NPPN_LANGCHANGED
+	UPDATE_ALL      = UPDATE_CURSOR | UPDATE_BUFFER | UPDATE_LANGUAGE
+};
+
+/**
+ * @brief UpdateReason flags of a Notepad++ or Scintilla notification,
+ * UPDATE_NONE for the notifications that do not change the presence
+ */
+unsigned NotificationReasons(unsigned code) noexcept;
+
+struct UpdateSchedulerStats
+{
+	uint64_t received  = 0; // notifications that reached the scheduler
+	uint64_t merged    = 0; // notifications folded into a pending update
+	uint64_t processed = 0; // presence rebuilds actually performed
+	uint64_t immediate = 0; // rebuilds that did not wait for the window
+};
+
+/**
+ * Coalesces editor notifications into at most one presence rebuild per
+ * refresh window. The class only holds the policy; the caller supplies the
+ * clock (milliseconds) and owns the timer that runs the deferred flush,
+ * which keeps it usable outside of Notepad++.
+ */
+class UpdateScheduler
+{
+public:
+	UpdateScheduler() = default;
+	UpdateScheduler(const UpdateScheduler&) = delete;
+	UpdateScheduler& operator=(const UpdateScheduler&) = delete;
+
+	void SetInterval(uint64_t milliseconds) noexcept { _interval = milliseconds; }
+	uint64_t GetInterval() const noexcept { return _interval; }
+
+	/**
+	 * @brief Records a notification
+	 * @param reasons UpdateReason flags of the notification
+	 * @param now Current time in milliseconds
+	 * @return true if the update must run now, false if it was merged into
+	 * the pending one and a flush must be armed for FlushDelay(now)
+	 */
+	bool Notify(unsigned reasons, uint64_t now) noexcept;
+
+	/**
+	 * @brief Milliseconds left until the pending update may run
+	 */
+	uint64_t FlushDelay(uint64_t now) const noexcept;
+
+	/**
+	 * @brief Takes the accumulated reasons and starts a new window
+	 * @return The merged UpdateReason flags, UPDATE_NONE if nothing is pending
+	 */
+	unsigned TakeDirty(uint64_t now) noexcept;
+
+	bool IsFlushArmed() const noexcept { return _flushArmed; }
+	void SetFlushArmed(bool armed) noexcept { _flushArmed = armed; }
+
+	const UpdateSchedulerStats& GetStats() const noexcept { return _stats; }
+
+private:
+	uint64_t _interval   = 1000;
+	uint64_t _lastRun    = 0;
+	unsigned _dirty      = UPDATE_NONE;
+	bool     _hasRun     = false;
+	bool     _flushArmed = false;
+	UpdateSchedulerStats _stats{};
+};
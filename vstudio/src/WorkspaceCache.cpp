@@ -0,0 +1,207 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "WorkspaceCache.hpp"
+
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+const WorkspaceInfo& WorkspaceCache::Lookup(const std::string& directory)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    auto it = _entries.find(directory);
+    if (it != _entries.end())
+    {
+        Entry& entry = it->second;
+        entry.usedAt = now;
+        if (now - entry.checkedAt < REVALIDATE_INTERVAL)
+        {
+            _stats.hits++;
+            return entry.info;
+        }
+
+        _stats.revalidations++;
+        if (IsStillValid(entry))
+        {
+            // The markers are where they were, only the remote may have
+            // changed
+            if (entry.hasGitFolder)
+            {
+                std::error_code ec;
+                const auto configTime = fs::last_write_time(fs::path(entry.info.root) / ".git" / "config", ec);
+                if (configTime != entry.configTime)
+                {
+                    entry.configTime = configTime;
+                    ReadRepositoryUrl((fs::path(entry.info.root) / ".git" / "config").string(),
+                        entry.info.repositoryUrl);
+                }
+            }
+            entry.checkedAt = now;
+            return entry.info;
+        }
+
+        entry = Entry{};
+        Search(directory, entry);
+        if (entry.hasGitFolder)
+        {
+            ReadRepositoryUrl((fs::path(entry.info.root) / ".git" / "config").string(),
+                entry.info.repositoryUrl);
+        }
+        entry.checkedAt = entry.usedAt = now;
+        return entry.info;
+    }
+
+    _stats.misses++;
+    if (_entries.size() >= MAX_ENTRIES)
+        EvictLeastRecentlyUsed();
+
+    Entry& entry = _entries[directory];
+    Search(directory, entry);
+    if (entry.hasGitFolder)
+    {
+        ReadRepositoryUrl((fs::path(entry.info.root) / ".git" / "config").string(),
+            entry.info.repositoryUrl);
+    }
+    entry.checkedAt = entry.usedAt = now;
+    return entry.info;
+}
+
+bool WorkspaceCache::IsStillValid(const Entry& entry)
+{
+    // Without a workspace there is no marker to check, one may have been
+    // created anywhere above the directory
+    if (!entry.info.found)
+        return false;
+
+    std::error_code ec;
+    const fs::path root = entry.info.root;
+    if (entry.hasGitFolder)
+        return fs::exists(root / ".git", ec);
+    if (!fs::exists(root / ".gitignore", ec))
+        return false;
+    // A nested .gitignore also depends on the enclosing repository
+    return entry.info.repositoryRoot.empty() ||
+        fs::exists(fs::path(entry.info.repositoryRoot) / ".git", ec);
+}
+
+void WorkspaceCache::EvictLeastRecentlyUsed()
+{
+    // Only runs on a miss with a full cache, a scan of MAX_ENTRIES is
+    // cheaper than the search that follows it
+    auto oldest = _entries.begin();
+    for (auto it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        if (it->second.usedAt < oldest->second.usedAt)
+            oldest = it;
+    }
+    if (oldest != _entries.end())
+        _entries.erase(oldest);
+}
+
+void WorkspaceCache::Clear() noexcept
+{
+    _entries.clear();
+}
+
+void WorkspaceCache::Search(fs::path currentDir, Entry& entry)
+{
+    std::error_code ec;
+    while (!currentDir.empty())
+    {
+        bool existsGitignoreFile = fs::exists(currentDir / ".gitignore", ec);
+        bool existsGitFolder = fs::exists(currentDir / ".git", ec);
+        if (existsGitFolder || existsGitignoreFile)
+        {
+            WorkspaceInfo& info = entry.info;
+            info.found = true;
+            info.root = currentDir.string();
+            info.name = info.root.find_last_of("\\/") != std::string::npos ?
+                info.root.substr(info.root.find_last_of("\\/") + 1) :
+                info.root;
+            info.gitignorePath = (currentDir / ".gitignore").string();
+
+            entry.hasGitFolder = existsGitFolder;
+            if (existsGitFolder)
+            {
+                entry.configTime = fs::last_write_time(currentDir / ".git" / "config", ec);
+                info.repositoryRoot = info.root;
+                return;
+            }
+
+            // A nested .gitignore, the ignore files of the enclosing
+            // repository still apply to it
+            for (fs::path parent = currentDir.parent_path(); !parent.empty(); parent = parent.parent_path())
+            {
+                if (fs::exists(parent / ".git", ec))
+                {
+                    info.repositoryRoot = parent.string();
+                    break;
+                }
+                if (parent == parent.parent_path()) // root reached
+                    break;
+            }
+            return;
+        }
+
+        auto tempCurrentDir = currentDir;
+        currentDir = currentDir.parent_path();
+        if (currentDir == tempCurrentDir) // root reached
+            break;
+    }
+}
+
+void WorkspaceCache::ReadRepositoryUrl(const std::string& fileConfig, std::string& url)
+{
+    url.clear();
+
+    std::ifstream file{ fs::path(fileConfig) };
+    if (!file.is_open())
+        return;
+
+    std::string line;
+    bool inRemoteOrigin = false;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (!line.empty() && line[0] == '[')
+            inRemoteOrigin = line.find("[remote \"origin\"]") != std::string::npos;
+        else if (inRemoteOrigin)
+        {
+            size_t pos = line.find("url = ");
+            if (pos != std::string::npos)
+            {
+                url = line.substr(pos + 6); // move past "url = "
+                // Convert SSH URL to HTTPS if necessary
+                if (url.find("git@") == 0)
+                {
+                    size_t colonPos = url.find(':');
+                    if (colonPos != std::string::npos)
+                    {
+                        std::string domain = url.substr(4, colonPos - 4); // Skip "git@"
+                        std::string path = url.substr(colonPos + 1);
+                        url = "https://" + domain + "/" + path;
+                    }
+                }
+                else if (url.find("http://") == 0)
+                    url.replace(0, 7, "https://");
+                break;
+            }
+        }
+    }
+}
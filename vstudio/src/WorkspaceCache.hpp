@@ -0,0 +1,100 @@
+// Copyright (C) 2026 Zukaritasu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+struct WorkspaceInfo
+{
+    bool found = false;
+    std::string name;          // Last component of the workspace directory
+    std::string root;          // Absolute path of the workspace directory
+    std::string repositoryUrl; // Remote "origin" URL, empty if there is none
+    std::string gitignorePath; // root/.gitignore, it may not exist
+    // Directory that contains .git, either root or one of its parents when
+    // root was found by a nested .gitignore. Empty outside a repository
+    std::string repositoryRoot;
+};
+
+struct WorkspaceCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t revalidations = 0;
+};
+
+/**
+ * Caches the workspace that owns each directory. A lookup within
+ * REVALIDATE_INTERVAL of the last check makes no filesystem calls at all;
+ * after that, the entry is validated again by checking that the workspace
+ * markers still exist. The URL is read again only if the modification time
+ * of .git/config changed. Only a failed validation, or a directory outside
+ * of any workspace, searches the directory tree again. A marker created
+ * closer to the file is found once the entry is evicted or cleared.
+ *
+ * When the cache is full the least recently used entry is evicted.
+ */
+class WorkspaceCache
+{
+public:
+    static constexpr std::chrono::seconds REVALIDATE_INTERVAL{ 5 };
+
+    WorkspaceCache() = default;
+    WorkspaceCache(const WorkspaceCache&) = delete;
+    WorkspaceCache& operator=(const WorkspaceCache&) = delete;
+
+    /**
+     * @brief Returns the workspace that contains the directory
+     * @param directory Absolute path of the directory of the current file
+     * @return Cached information, found is false if the directory does not
+     * belong to any workspace
+     */
+    const WorkspaceInfo& Lookup(const std::string& directory);
+
+    void Clear() noexcept;
+    const WorkspaceCacheStats& GetStats() const noexcept { return _stats; }
+
+    /**
+     * @brief Reads the URL of the "origin" remote from a .git/config file
+     *
+     * SSH URLs are converted to HTTPS. The url is cleared if the file does
+     * not exist.
+     */
+    static void ReadRepositoryUrl(const std::string& fileConfig, std::string& url);
+
+private:
+    static constexpr size_t MAX_ENTRIES = 256;
+
+    struct Entry
+    {
+        WorkspaceInfo info;
+        bool hasGitFolder = false;
+        std::filesystem::file_time_type configTime{};
+        std::chrono::steady_clock::time_point checkedAt{};
+        std::chrono::steady_clock::time_point usedAt{};
+    };
+
+    std::unordered_map<std::string, Entry> _entries;
+    WorkspaceCacheStats _stats{};
+
+    static bool IsStillValid(const Entry& entry);
+    void EvictLeastRecentlyUsed();
+    static void Search(std::filesystem::path currentDir, Entry& entry);
+};